@@ -80,7 +80,7 @@ int main(Platform::Array<Platform::String^>^ args)
 	p->setPitch(0.5f);
 	while (p->isPlaying())
 	{
-		hlog::writef("", "    - " SOUND_NORMAL " - samples: %d - time: %f", p->getSamplePosition(), p->getTimePosition());
+		hlog::writef("", "    - " SOUND_NORMAL " - samples: %lld - time: %f", (long long)p->getSamplePosition(), p->getTimePosition());
 		hthread::sleep(100);
 		xal::manager->update(0.1f);
 	}
@@ -95,7 +95,7 @@ int main(Platform::Array<Platform::String^>^ args)
 	p->play();
 	while (p->isPlaying())
 	{
-		hlog::writef("", "    - " SOUND_STREAMED " - samples: %d - time: %f", p->getSamplePosition(), p->getTimePosition());
+		hlog::writef("", "    - " SOUND_STREAMED " - samples: %lld - time: %f", (long long)p->getSamplePosition(), p->getTimePosition());
 		hthread::sleep(100);
 		xal::manager->update(0.1f);
 	}
@@ -18,6 +18,7 @@
 	#define RESOURCE_PATH "./"
 #endif
 
+#include <math.h>
 #include <stdio.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -25,11 +26,14 @@
 
 #include <hltypes/harray.h>
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 #include <hltypes/hthread.h>
 
 #include <xal/AudioManager.h>
 #include <xal/Player.h>
+#include <xal/Sound.h>
 #include <xal/xal.h>
 #include <xalutil/ParallelSoundManager.h>
 #include <xalutil/Playlist.h>
@@ -39,6 +43,8 @@
 //#define _USE_THREADING
 //#define _USE_MEMORY_MANAGEMENT
 //#define _USE_RAM_SOURCES
+//#define _USE_MAPPED_SOURCES
+//#define _USE_PCM_CACHE
 
 #define _TEST_BASIC
 //#define _TEST_SOUND
@@ -55,6 +61,12 @@
 //#define _TEST_UTIL_PLAYLIST
 //#define _TEST_UTIL_PARALLEL_SOUNDS
 
+//#define _TEST_GENERATED
+//#define _TEST_BANK
+//#define _TEST_BULK_LOAD
+//#define _TEST_EXTERNAL_MEMORY
+//#define _TEST_BENCHMARK_DECODING // OGG and FLAC, build libxal with and without _OGG_TREMOR to compare OGG decoders
+
 #ifndef _USE_LINKS
 #define S_BARK "bark"
 #define S_WIND "wind"
@@ -77,6 +89,8 @@
 #endif
 #ifdef _USE_RAM_SOURCES
 #define SOURCE_MODE xal::SourceMode::Ram
+#elif defined(_USE_MAPPED_SOURCES)
+#define SOURCE_MODE xal::SourceMode::Mapped
 #else
 #define SOURCE_MODE xal::SourceMode::Disk
 #endif
@@ -104,13 +118,13 @@ void _test_sound(xal::Player* player)
 		xal::manager->update(0.1f);
 		player->pause();
 
-		hlog::writef("", "  - PAUSE: %02d - %05d %7.3f", i, player->getSamplePosition(), player->getTimePosition());
+		hlog::writef("", "  - PAUSE: %02d - %05lld %7.3f", i, (long long)player->getSamplePosition(), player->getTimePosition());
 
 		hthread::sleep(100);
 		xal::manager->update(0.1f);
 		player->play();
 
-		hlog::writef("", "  - PLAY:  %02d - %05d %7.3f", i, player->getSamplePosition(), player->getTimePosition());
+		hlog::writef("", "  - PLAY:  %02d - %05lld %7.3f", i, (long long)player->getSamplePosition(), player->getTimePosition());
 	}
 	xal::manager->update(1.0f);
 }
@@ -402,6 +416,140 @@ void _test_util_parallel_sounds(xal::Player* player)
 	}
 }
 
+int _generateSine(unsigned char* output, int size, int64_t position, void* userData)
+{
+	// mono 16 bit sine wave at 440 Hz that ends after 3 seconds
+	short* data = (short*)output;
+	int64_t sample = position / 2;
+	int count = (int)hmin((int64_t)(size / 2), hmax(44100 * 3 - sample, (int64_t)0));
+	for_iter (i, 0, count)
+	{
+		data[i] = (short)(sinf((sample + i) * 440.0f * 2.0f * 3.14159265f / 44100) * 16000);
+	}
+	return (count * 2);
+}
+
+void _test_generated(xal::Player* player)
+{
+	hlog::write("", "  - start test generated...");
+	xal::manager->createSound("sine", "sound", &_generateSine, NULL, 1, 44100, 16);
+	xal::Player* p1 = xal::manager->createPlayer("sine");
+	p1->play();
+	while (p1->isPlaying())
+	{
+		hthread::sleep(100);
+		xal::manager->update(0.1f);
+	}
+	xal::manager->destroyPlayer(p1);
+	xal::manager->destroySound(xal::manager->getSound("sine"));
+}
+
+void _releaseSine(unsigned char* data, void* userData)
+{
+	hlog::write("", "  - releasing external sine data");
+	delete[] data;
+}
+
+void _test_external_memory(xal::Player* player)
+{
+	hlog::write("", "  - start test external memory...");
+	// 3 seconds of the same sine wave, but owned by the application and never copied by XAL
+	int size = 44100 * 3 * 2;
+	unsigned char* data = new unsigned char[size];
+	_generateSine(data, size, 0, NULL);
+	xal::manager->createSound("external_sine", "sound", data, (int64_t)size, 1, 44100, 16, &_releaseSine, NULL);
+	xal::Player* p1 = xal::manager->createPlayer("external_sine");
+	p1->play();
+	while (p1->isPlaying())
+	{
+		hthread::sleep(100);
+		xal::manager->update(0.1f);
+	}
+	xal::manager->destroyPlayer(p1);
+	xal::manager->destroySound(xal::manager->getSound("external_sine"));
+}
+
+void _test_bank(xal::Player* player)
+{
+	hlog::write("", "  - start test bank...");
+	// usually done ahead of time with the xalbank tool
+	xal::manager->createBank(RESOURCE_PATH, "test.xalbank");
+	harray<hstr> names = xal::manager->createSoundsFromBank("test.xalbank", "bank_");
+	hlog::writef("", "  - created %d sounds from bank", names.size());
+	xal::Player* p1 = xal::manager->createPlayer("bank_wind");
+	p1->play();
+	for_iter (i, 0, 50)
+	{
+		hthread::sleep(100);
+		xal::manager->update(0.1f);
+	}
+	xal::manager->destroyPlayer(p1);
+	xal::manager->destroySoundsWithPrefix("bank_");
+}
+
+void _test_bulk_load(xal::Player* player)
+{
+	hlog::write("", "  - start test bulk load...");
+	int64_t start = htickCount();
+	harray<hstr> names = xal::manager->createSoundsFromPathAsync(RESOURCE_PATH, "bulk", "bulk_");
+	hlog::writef("", "  - registered %d sounds in %lld ms", names.size(), (long long)(htickCount() - start));
+	int pending = 0;
+	while (!xal::manager->waitForAsyncLoads(names, 0.1f))
+	{
+		pending = xal::manager->getPendingAsyncLoadCount(names);
+		hlog::writef("", "  - loaded %d / %d", names.size() - pending, names.size());
+	}
+	hlog::writef("", "  - decoded %d sounds in %lld ms", names.size(), (long long)(htickCount() - start));
+	xal::manager->destroySoundsWithPrefix("bulk_");
+}
+
+void _test_benchmark_decoding(xal::Player* player)
+{
+	hlog::write("", "  - start benchmark decoding...");
+	// streamed buffers don't decode anything on their own so only readPcmData() is measured
+	xal::manager->createCategory("benchmark", xal::BufferMode::Streamed, xal::SourceMode::Ram);
+	harray<hstr> names = xal::manager->createSoundsFromPath(RESOURCE_PATH, "benchmark", "benchmark_");
+	names += xal::manager->createSoundsFromPath(RESOURCE_PATH "streamable", "benchmark", "benchmark_");
+	harray<xal::Format> formats;
+	formats += xal::Format::OGG;
+	formats += xal::Format::FLAC;
+	const int iterations = 10;
+	xal::Sound* sound = NULL;
+	hstream stream;
+	int64_t start = 0;
+	float time = 0.0f;
+	float totalTime = 0.0f;
+	float totalDuration = 0.0f;
+	foreach (xal::Format, it, formats)
+	{
+		totalTime = 0.0f;
+		totalDuration = 0.0f;
+		foreach (hstr, it2, names)
+		{
+			sound = xal::manager->getSound(*it2);
+			if (sound == NULL || sound->getFormat() != (*it))
+			{
+				continue;
+			}
+			start = htickCount();
+			for_iter (i, 0, iterations)
+			{
+				stream.clear();
+				sound->readPcmData(stream);
+			}
+			time = (htickCount() - start) * 0.001f;
+			totalTime += time;
+			totalDuration += sound->getDuration() * iterations;
+			hlog::writef("", "  - %s: %.3f s for %d decodes, %.1fx realtime", sound->getFilename().cStr(), time, iterations, sound->getDuration() * iterations / hmax(time, 0.001f));
+		}
+		if (totalDuration > 0.0f)
+		{
+			hlog::writef("", "  - total %s: %.3f s, %.1fx realtime", (*it).getName().cStr(), totalTime, totalDuration / hmax(totalTime, 0.001f));
+		}
+	}
+	xal::manager->destroySoundsWithPrefix("benchmark_");
+}
+
 #ifndef _WINRT
 int main(int argc, char **argv)
 #else
@@ -418,6 +566,9 @@ int main(Platform::Array<Platform::String^>^ args)
 #else
 	xal::init(xal::AudioSystemType::Default, hwnd, true, 0.01f);
 #endif
+#ifdef _USE_PCM_CACHE
+	xal::manager->setPcmCachePath("pcm_cache");
+#endif
 #ifdef _USE_MEMORY_MANAGEMENT
 	xal::manager->createCategory("sound", xal::BufferMode::Managed, SOURCE_MODE);
 #endif
@@ -475,6 +626,21 @@ int main(Platform::Array<Platform::String^>^ args)
 #ifdef _TEST_UTIL_PARALLEL_SOUNDS
 	_test_util_parallel_sounds(player);
 #endif
+#ifdef _TEST_GENERATED
+	_test_generated(player);
+#endif
+#ifdef _TEST_BANK
+	_test_bank(player);
+#endif
+#ifdef _TEST_BULK_LOAD
+	_test_bulk_load(player);
+#endif
+#ifdef _TEST_EXTERNAL_MEMORY
+	_test_external_memory(player);
+#endif
+#ifdef _TEST_BENCHMARK_DECODING
+	_test_benchmark_decoding(player);
+#endif
 
 	xal::manager->destroyPlayer(player);
 	hlog::write("", "  - done");
@@ -45,6 +45,9 @@ namespace xal
 		/// @var static const Format Format::RAW
 		/// @brief Raw audio data Format.
 		HL_ENUM_DECLARE(Format, Memory);
+		/// @var static const Format Format::Generated
+		/// @brief Audio data generated by a callback.
+		HL_ENUM_DECLARE(Format, Generated);
 		/// @var static const Format Format::FLAC
 		/// @brief Unknown format, usually indicates errors.
 		HL_ENUM_DECLARE(Format, Unknown);
@@ -84,22 +87,45 @@ namespace xal
 		/// @var static const SourceMode SourceMode::Ram
 		/// @brief Copies data to RAM buffer and accesses it from there.
 		HL_ENUM_DECLARE(SourceMode, Ram);
+		/// @var static const SourceMode SourceMode::Mapped
+		/// @brief Memory-maps the file so all sources of the same file share the data which the OS loads on demand.
+		/// @note Falls back to Disk if the file cannot be mapped, e.g. when it is inside an archive.
+		HL_ENUM_DECLARE(SourceMode, Mapped);
 	));
 
+	/// @brief Callback that generates the audio data of a Sound while it is playing.
+	/// @param[out] output Where the PCM data is written to.
+	/// @param[in] size Requested byte size, always a multiple of the frame size.
+	/// @param[in] position Byte position of the requested data, 0 when playback starts from the beginning.
+	/// @param[in] userData User data that was passed when creating the Sound.
+	/// @return Number of bytes written. Writing less than requested ends the Sound.
+	/// @note This is called during the audio update which may run in a separate thread.
+	typedef int (*GeneratorCallback)(unsigned char* output, int size, int64_t position, void* userData);
+	/// @brief Callback that releases audio data owned by the application once a Sound doesn't need it anymore.
+	/// @param[in] data The audio data that was passed when creating the Sound.
+	/// @param[in] userData User data that was passed when creating the Sound.
+	typedef void (*ReleaseCallback)(unsigned char* data, void* userData);
+
+	class Bank;
 	class Buffer;
 	class Category;
+	class IoProvider;
 	class Player;
 	class Sound;
 	class Source;
+	struct BankEntry;
 
 	/// @brief Provides generic functionality regarding audio management.
 	class xalExport AudioManager
 	{
 	public:
+		friend class Bank;
 		friend class Buffer;
 		friend class Category;
+		friend class MetaDataCache;
 		friend class Player;
 		friend class Sound;
+		friend class Source;
 
 		/// @brief Destructor.
 		virtual ~AudioManager();
@@ -138,6 +164,21 @@ namespace xal
 		float getGlobalGainFadeTarget();
 		/// @brief Gets and sets the suspend gain fade speed.
 		HL_DEFINE_GETSET(float, suspendResumeFadeTime, SuspendResumeFadeTime);
+		/// @brief Gets/sets whether streamed Sounds use seek index files which are created on the first seek when missing.
+		HL_DEFINE_ISSET(seekIndexEnabled, SeekIndexEnabled);
+		/// @brief Gets/sets the directory where seek index files created at runtime are stored.
+		/// @note If empty, seek index files are only read from next to the audio files and indices created at runtime are not stored.
+		HL_DEFINE_GETSET(hstr, seekIndexPath, SeekIndexPath);
+		/// @brief Gets/sets the directory where decoded and converted PCM data of fully buffered Sounds is cached.
+		/// @note If empty, no PCM data is cached. Cache entries are validated by the audio file's size and modification time, the content is only hashed when those can't confirm an entry so they never have to be invalidated manually.
+		HL_DEFINE_GETSET(hstr, pcmCachePath, PcmCachePath);
+		/// @brief Gets/sets the IoProvider used to access audio files.
+		/// @note If NULL, audio files are accessed through hresource. The IoProvider is not owned by the AudioManager.
+		/// @note Seek indices next to the audio files are accessed through the IoProvider as well. Sound banks and cache files are always accessed through hresource and hfile.
+		HL_DEFINE_GETSET(IoProvider*, ioProvider, IoProvider);
+		/// @brief Gets/sets how many bytes of compressed data asynchronous loading may keep in RAM while it waits to be decoded.
+		/// @note 0 means no limit. A single file larger than the limit is still loaded, but only once nothing else is waiting. Memory-mapped files are not copied and don't count towards the limit.
+		HL_DEFINE_GETSET(int64_t, maxAsyncPrefetchSize, MaxAsyncPrefetchSize);
 		/// @return Gets a list of all currently existing Player instances.
 		harray<Player*> getPlayers();
 		/// @return Gets a map of all loaded Sound instances.
@@ -171,6 +212,7 @@ namespace xal
 		/// @param[in] categoryName Name of the Category where to register the new Sound.
 		/// @param[in] prefix Used to differentiate between Sounds that have the same filename (e.g. by using a directory path as prefix).
 		/// @return The newly created Sound.
+		/// @note Unless the Category uses BufferMode::Full or BufferMode::Async, only the Sound's name and filename are registered. Its Buffer and Source are created when the first Player is created and destroyed again when unused for longer than the idle player unload time or when clearMemory() is called.
 		Sound* createSound(chstr filename, chstr categoryName, chstr prefix = "");
 		/// @brief Creates a new Sound within a Category form raw data.
 		/// @param[in] name Name of the new Sound.
@@ -182,6 +224,31 @@ namespace xal
 		/// @param[in] bitsPerSample Bits per sample.
 		/// @return The newly created Sound.
 		Sound* createSound(chstr name, chstr categoryName, unsigned char* data, int size, int channels, int samplingRate, int bitsPerSample);
+		/// @brief Creates a new Sound within a Category that plays raw data owned by the application without copying it.
+		/// @param[in] name Name of the new Sound.
+		/// @param[in] categoryName Name of the Category where to register the new Sound.
+		/// @param[in] data Raw audio data.
+		/// @param[in] size Raw audio data byte size.
+		/// @param[in] channels Number of channels.
+		/// @param[in] samplingRate Sampling rate.
+		/// @param[in] bitsPerSample Bits per sample.
+		/// @param[in] releaseCallback Called with data and userData when the Sound is destroyed. Can be NULL.
+		/// @param[in] userData User data that is passed to the release callback.
+		/// @return The newly created Sound.
+		/// @note The data must stay valid until the Sound is destroyed. If the name is already used by another Sound, no Sound is created and the release callback is called right away.
+		/// @note The Sound is always streamed and each Player reads directly from the data, converting only the current chunk if needed, regardless of the Category's BufferMode.
+		Sound* createSound(chstr name, chstr categoryName, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		/// @brief Creates a new Sound within a Category that plays audio data generated by a callback.
+		/// @param[in] name Name of the new Sound.
+		/// @param[in] categoryName Name of the Category where to register the new Sound.
+		/// @param[in] callback Callback that generates the audio data.
+		/// @param[in] userData User data that is passed to the callback.
+		/// @param[in] channels Number of channels.
+		/// @param[in] samplingRate Sampling rate.
+		/// @param[in] bitsPerSample Bits per sample.
+		/// @return The newly created Sound.
+		/// @note The Sound is always streamed and each Player calls the callback separately, regardless of the Category's BufferMode.
+		Sound* createSound(chstr name, chstr categoryName, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
 		/// @brief Gets the Sound with the given name.
 		/// @param[in] name Name of the Sound.
 		/// @return The Sound with the given name.
@@ -209,6 +276,51 @@ namespace xal
 		/// @return A list of all Sound names that were created.
 		/// @note If the Category does not exist, it will be created.
 		harray<hstr> createSoundsFromPath(chstr path, chstr categoryName, chstr prefix);
+		/// @brief Creates Sounds from a path and creates a Category for each directory, but decodes them asynchronously.
+		/// @param[in] path Path where the directories are located.
+		/// @param[in] prefix Used to differentiate between Sounds that have the same filename (e.g. by using a directory path as prefix).
+		/// @return A list of all Sound names that were created.
+		/// @note The Sounds are only registered while the manager is locked. Files are read by the async loader and decoded on as many threads as there are CPU cores.
+		/// @note Throws an exception if one of the Categories already exists with a BufferMode other than BufferMode::Async.
+		/// @see getPendingAsyncLoadCount
+		/// @see waitForAsyncLoads
+		harray<hstr> createSoundsFromPathAsync(chstr path, chstr prefix = "");
+		/// @brief Creates Sounds from a path and assigns them to a Category, but decodes them asynchronously.
+		/// @param[in] path Path where the audio files are located.
+		/// @param[in] categoryName Name for the Category.
+		/// @param[in] prefix Used to differentiate between Sounds that have the same filename (e.g. by using a directory path as prefix).
+		/// @return A list of all Sound names that were created.
+		/// @note If the Category does not exist, it will be created with BufferMode::Async. Throws an exception if the Category already exists with a different BufferMode.
+		/// @see getPendingAsyncLoadCount
+		/// @see waitForAsyncLoads
+		harray<hstr> createSoundsFromPathAsync(chstr path, chstr categoryName, chstr prefix);
+		/// @brief Gets the number of Sounds that are still queued for asynchronous loading or are being decoded.
+		/// @return The number of Sounds that are still queued for asynchronous loading or are being decoded.
+		/// @note This can be used to display loading progress after createSoundsFromPathAsync().
+		int getPendingAsyncLoadCount();
+		/// @brief Gets the number of given Sounds that are still queued for asynchronous loading or are being decoded.
+		/// @param[in] soundNames Names of the Sounds, e.g. as returned by createSoundsFromPathAsync().
+		/// @return The number of given Sounds that are still queued for asynchronous loading or are being decoded.
+		/// @note This can be used to display the loading progress of a single batch while other Sounds are loaded asynchronously as well. Sounds whose file failed to load are not pending anymore.
+		int getPendingAsyncLoadCount(const harray<hstr>& soundNames);
+		/// @brief Blocks until all asynchronously loaded Sounds have been decoded.
+		/// @param[in] timeout Maximum time to wait in seconds. 0 means indefinitely.
+		/// @return True if all asynchronous loads have finished.
+		/// @note The manager is not locked while waiting so other threads may keep using it.
+		bool waitForAsyncLoads(float timeout = 0.0f);
+		/// @brief Blocks until the given Sounds have been loaded.
+		/// @param[in] soundNames Names of the Sounds, e.g. as returned by createSoundsFromPathAsync().
+		/// @param[in] timeout Maximum time to wait in seconds. 0 means indefinitely.
+		/// @return True if all given Sounds have finished loading or failed to load.
+		/// @note The manager is only locked while checking the Sounds so other threads may keep using it.
+		bool waitForAsyncLoads(const harray<hstr>& soundNames, float timeout = 0.0f);
+		/// @brief Creates all Sounds stored in a sound bank and creates their Categories.
+		/// @param[in] filename Filename of the sound bank.
+		/// @param[in] prefix Used to differentiate between Sounds that have the same filename (e.g. by using a directory path as prefix).
+		/// @return A list of all Sound names that were created.
+		/// @note The bank is memory-mapped once and its index already contains the metadata of all Sounds so no audio files have to be accessed.
+		/// @see createBank
+		harray<hstr> createSoundsFromBank(chstr filename, chstr prefix = "");
 
 		/// @brief Creates a Player for a Sound.
 		/// @param[in] soundName Name of the Sound for which the player will be used.
@@ -285,6 +397,34 @@ namespace xal
 		/// @note This is useful when the app goes out of focus. It does nothing if the system hasn't been suspended previously.
 		void resumeAudio();
 
+		/// @brief Creates the seek index file for an audio file ahead of time.
+		/// @param[in] filename Filename of the audio file.
+		/// @return True if the seek index file was created.
+		/// @note Currently only OGG files use seek indices.
+		/// @note If no seek index path is set, the file is written next to the audio file so it can be shipped together with it.
+		/// @see setSeekIndexEnabled
+		bool createSeekIndex(chstr filename);
+		/// @brief Packs all audio files in a path into a sound bank file.
+		/// @param[in] path Path where the directories are located.
+		/// @param[in] filename Filename of the sound bank.
+		/// @return True if the sound bank was created.
+		/// @note Directories are used as Categories the same way as in createSoundsFromPath().
+		/// @note The metadata is probed for the current audio system. Sounds of banks packed with an audio system that mixes a different sample format probe their metadata again.
+		/// @see createSoundsFromBank
+		bool createBank(chstr path, chstr filename);
+		/// @brief Loads a metadata cache file so Sounds know their size, format and duration without accessing their audio files.
+		/// @param[in] filename Filename of the metadata cache.
+		/// @return True if the metadata cache was loaded.
+		/// @note Has to be called before Sounds are created to have an effect.
+		/// @note Entries are keyed by path, file size and modification time so changed files are probed again.
+		/// @see saveMetaDataCache
+		bool loadMetaDataCache(chstr filename);
+		/// @brief Saves the metadata of all audio files that were probed or loaded from a cache so far.
+		/// @param[in] filename Filename of the metadata cache.
+		/// @return True if the metadata cache was saved.
+		/// @see loadMetaDataCache
+		bool saveMetaDataCache(chstr filename);
+
 		/// @brief Adds a custom audio file extension.
 		/// @param[in] extension File extension to add.
 		void addAudioExtension(chstr extension);
@@ -327,6 +467,16 @@ namespace xal
 		float globalGainFadeTime;
 		/// @brief Fade time when suspending and resuming audio system.
 		float suspendResumeFadeTime;
+		/// @brief Whether streamed Sounds use seek index files.
+		bool seekIndexEnabled;
+		/// @brief Directory where seek index files are stored.
+		hstr seekIndexPath;
+		/// @brief Directory where decoded PCM data is cached.
+		hstr pcmCachePath;
+		/// @brief Custom access to audio files.
+		IoProvider* ioProvider;
+		/// @brief Maximum size of compressed data waiting to be decoded.
+		int64_t maxAsyncPrefetchSize;
 		/// @brief List of registered audio categories.
 		hmap<hstr, Category*> categories;
 		/// @brief Currently existing Player instances.
@@ -340,6 +490,8 @@ namespace xal
 		hmap<hstr, Sound*> sounds;
 		/// @brief List Buffer instances.
 		harray<Buffer*> buffers;
+		/// @brief Sounds whose deferred Buffer currently exists, but isn't used by any Player.
+		harray<Sound*> idleDeferredSounds;
 		/// @brief List of file extensions supported.
 		harray<hstr> extensions;
 		/// @brief Thread instance handling the threaded update.
@@ -390,6 +542,12 @@ namespace xal
 		/// @note This method is not thread-safe and is for internal usage only.
 		virtual Sound* _createSound(chstr name, chstr categoryName, unsigned char* data, int size, int channels, int samplingRate, int bitsPerSample);
 		/// @note This method is not thread-safe and is for internal usage only.
+		virtual Sound* _createSound(chstr name, chstr categoryName, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
+		/// @note This method is not thread-safe and is for internal usage only.
+		virtual Sound* _createSound(chstr name, chstr categoryName, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		/// @note This method is not thread-safe and is for internal usage only.
+		virtual Sound* _createSound(const BankEntry& bankEntry, chstr prefix);
+		/// @note This method is not thread-safe and is for internal usage only.
 		Sound* _getSound(chstr name);
 		/// @note This method is not thread-safe and is for internal usage only.
 		bool _hasSound(chstr name) const;
@@ -401,6 +559,14 @@ namespace xal
 		harray<hstr> _createSoundsFromPath(chstr path, chstr prefix);
 		/// @note This method is not thread-safe and is for internal usage only.
 		harray<hstr> _createSoundsFromPath(chstr path, chstr category, chstr prefix);
+		/// @note This method is not thread-safe and is for internal usage only.
+		harray<hstr> _createSoundsFromPathAsync(chstr path, chstr prefix);
+		/// @note This method is not thread-safe and is for internal usage only.
+		harray<hstr> _createSoundsFromPathAsync(chstr path, chstr category, chstr prefix);
+		/// @note This method is not thread-safe and is for internal usage only.
+		int _getPendingAsyncLoadCount(const harray<hstr>& soundNames);
+		/// @note This method is not thread-safe and is for internal usage only.
+		harray<hstr> _createSoundsFromBank(chstr filename, chstr prefix);
 
 		/// @note This method is not thread-safe and is for internal usage only.
 		Player* _createPlayer(chstr name);
@@ -420,7 +586,15 @@ namespace xal
 		/// @note This method is not thread-safe and is for internal usage only.
 		Buffer* _createBuffer(Category* category, unsigned char* data, int size, int channels, int samplingRate, int bitsPerSample);
 		/// @note This method is not thread-safe and is for internal usage only.
+		Buffer* _createBuffer(Buffer* sharedBuffer);
+		/// @note This method is not thread-safe and is for internal usage only.
+		Buffer* _createBuffer(Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
+		/// @note This method is not thread-safe and is for internal usage only.
+		Buffer* _createBuffer(Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		/// @note This method is not thread-safe and is for internal usage only.
 		void _destroyBuffer(Buffer* buffer);
+		/// @note This method is not thread-safe and is for internal usage only.
+		void _releaseDeferredBuffers(bool ignoreIdleTime);
 
 		/// @note This method is not thread-safe and is for internal usage only.
 		virtual Player* _createSystemPlayer(Sound* sound) = 0;
@@ -469,6 +643,12 @@ namespace xal
 		/// @param[in] bitsPerSample Bits per sample.
 		/// @param[in,out] stream The data stream buffer.
 		virtual void _convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSample, hstream& stream);
+		/// @brief Gets the format that audio data will have after it was processed by _convertStream().
+		/// @param[in,out] channels Number of channels.
+		/// @param[in,out] samplingRate Sampling rate.
+		/// @param[in,out] bitsPerSample Bits per sample.
+		/// @note 32 bits per sample always denote IEEE float samples within XAL.
+		virtual void _getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const;
 
 		/// @brief Special additional processing for suspension, required for some implementations.
 		/// @note This method is not thread-safe and is for internal usage only.
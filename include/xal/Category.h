@@ -47,6 +47,20 @@ namespace xal
 		HL_DEFINE_GET(BufferMode, bufferMode, BufferMode);
 		/// @brief Gets the source-handling mode.
 		HL_DEFINE_GET(SourceMode, sourceMode, SourceMode);
+		/// @brief Gets/sets the amplitude threshold (0.0-1.0) below which leading and trailing silence is trimmed when loading, 0.0 disables trimming.
+		HL_DEFINE_GETSET(float, silenceTrimThreshold, SilenceTrimThreshold);
+		/// @brief Gets/sets whether stereo data with identical channels is stored as mono.
+		HL_DEFINE_ISSET(monoFolding, MonoFolding);
+		/// @brief Gets/sets the sampling rate to which loaded data is downsampled, 0 keeps the original sampling rate.
+		HL_DEFINE_GETSET(int, storageSamplingRate, StorageSamplingRate);
+		/// @brief Gets/sets whether the loudness of Sounds is measured while decoding.
+		HL_DEFINE_ISSET(loudnessAnalysisEnabled, LoudnessAnalysisEnabled);
+		/// @brief Gets/sets the integrated loudness in LUFS to which Sounds are normalized (e.g. -23.0), 0.0 disables normalization.
+		/// @note Setting a target implies loudness analysis. Since the final gain can't exceed 1.0, louder Sounds are attenuated while quieter ones are only raised when playing below full gain.
+		HL_DEFINE_GETSET(float, loudnessTarget, LoudnessTarget);
+		/// @brief Gets/sets whether Sounds that aren't streamed keep their data compressed as IMA-ADPCM in memory and decode it while playing.
+		/// @note This only affects Sounds created afterwards. Their Players behave like streamed ones, but decoding IMA-ADPCM is much cheaper than decoding the original format.
+		HL_DEFINE_ISSET(adpcmStorage, AdpcmStorage);
 		/// @return True if gain is fading.
 		bool isGainFading();
 		/// @return True if Sounds in this Category are streamed.
@@ -54,6 +68,10 @@ namespace xal
 		/// @return True if Sounds in this Category have their data managed by the system.
 		bool isMemoryManaged() const;
 
+		/// @return True if any load-time optimization of PCM data is enabled.
+		/// @note Optimizations only apply to Sounds that aren't streamed and only if the audio system can play the result without further conversion.
+		bool isPcmOptimized() const;
+
 		/// @brief Fades the gain to another value.
 		/// @param[in] gainTarget The value to which the gain should be changed.
 		/// @param[in] fadeTime Time how long the gain fade should take.
@@ -74,6 +92,18 @@ namespace xal
 		BufferMode bufferMode;
 		/// @brief sourceMode How to handle the Source of the Sound.
 		SourceMode sourceMode;
+		/// @brief Amplitude threshold below which leading and trailing silence is trimmed.
+		float silenceTrimThreshold;
+		/// @brief Whether stereo data with identical channels is stored as mono.
+		bool monoFolding;
+		/// @brief Sampling rate to which loaded data is downsampled.
+		int storageSamplingRate;
+		/// @brief Whether the loudness of Sounds is measured while decoding.
+		bool loudnessAnalysisEnabled;
+		/// @brief Integrated loudness to which Sounds are normalized.
+		float loudnessTarget;
+		/// @brief Whether Sounds keep their data compressed as IMA-ADPCM in memory.
+		bool adpcmStorage;
 		
 		/// @note This method is not thread-safe and is for internal usage only.
 		float _getGain() const;
@@ -0,0 +1,68 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an interface for custom file access.
+
+#ifndef XAL_IO_PROVIDER_H
+#define XAL_IO_PROVIDER_H
+
+#include <hltypes/hstring.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	/// @brief Provides access to audio files that are not accessible through hresource (e.g. files inside of custom archives).
+	/// @note Methods can be called from the async loader threads so implementations have to be thread-safe.
+	class xalExport IoProvider
+	{
+	public:
+		/// @brief Destructor.
+		virtual ~IoProvider() { }
+
+		/// @brief Checks whether a file exists.
+		/// @param[in] filename Filename of the file.
+		/// @return True if the file exists.
+		virtual bool exists(chstr filename) = 0;
+		/// @brief Opens a file.
+		/// @param[in] filename Filename of the file.
+		/// @return A handle for the file or NULL if the file could not be opened.
+		virtual void* open(chstr filename) = 0;
+		/// @brief Closes a file.
+		/// @param[in] handle Handle of the file.
+		virtual void close(void* handle) = 0;
+		/// @brief Reads data from the current position.
+		/// @param[in] handle Handle of the file.
+		/// @param[out] data Where to store the data.
+		/// @param[in] size Number of bytes to read.
+		/// @return Number of bytes that were actually read.
+		virtual int read(void* handle, unsigned char* data, int size) = 0;
+		/// @brief Sets the current position.
+		/// @param[in] handle Handle of the file.
+		/// @param[in] position New absolute position.
+		/// @return True if successful.
+		virtual bool seek(void* handle, int64_t position) = 0;
+		/// @brief Gets the size of a file.
+		/// @param[in] handle Handle of the file.
+		/// @return The size of the file.
+		virtual int64_t size(void* handle) = 0;
+		/// @brief Gets direct access to a range of the file's data.
+		/// @param[in] handle Handle of the file.
+		/// @param[in] offset Start of the range.
+		/// @param[in] size Byte size of the range.
+		/// @return Pointer to the data or NULL if not supported.
+		/// @note The data must stay valid until the handle is closed. Reads are served from this memory instead of going through read(), but decoders still receive copies in their own buffers.
+		virtual const unsigned char* mapRange(void* handle, int64_t offset, int64_t size) { return NULL; }
+
+	};
+
+}
+
+#endif
@@ -51,17 +51,17 @@ namespace xal
 		/// @return Gets duration of the Sound.
 		float getDuration();
 		/// @return Gets byte-size of the Sound.
-		int getSize();
+		int64_t getSize();
 		/// @return Gets buffer-size in bytes of the Sound.
 		int getBufferSize();
 		/// @return Gets Buffer's idle time
 		float getBufferIdleTime();
 		/// @return Gets byte-size of the Sound's source file.
-		int getSourceSize();
+		int64_t getSourceSize();
 		/// @return Gets time position of the playback.
 		float getTimePosition();
 		/// @return Gets sample position of the playback.
-		unsigned int getSamplePosition();
+		int64_t getSamplePosition();
 		/// @return Gets Sound's category.
 		Category* getCategory() const;
 		
@@ -100,6 +100,14 @@ namespace xal
 		/// @note Unpause the Sound with play().
 		/// @see play
 		void pause(float fadeTime = 0.0f);
+		/// @brief Moves the playback position to a point in time.
+		/// @param[in] time Time position in seconds.
+		/// @note A playing Sound continues from the new position right away while a paused Sound is stopped. Otherwise the new position is used the next time the Sound is played.
+		void seek(float time);
+		/// @brief Moves the playback position to a sample.
+		/// @param[in] sample Sample position.
+		/// @see seek
+		void seekSamples(int64_t sample);
 
 	protected:
 		/// @brief The gain at which the Sound is played.
@@ -119,6 +127,9 @@ namespace xal
 		/// @brief How far the buffer is offset.
 		/// @note Different meaning and behavior depending on implementation.
 		float offset; // TODO - should be removed?
+		/// @brief Sample position where the next playback starts, -1 if not set.
+		/// @note Fully loaded Sounds have to apply this in the audio-system when the buffer is prepared.
+		int64_t seekSample;
 		/// @brief The Sound to be played.
 		Sound* sound;
 		/// @brief The Buffer used for feeding the audio-system with audio data.
@@ -127,7 +138,7 @@ namespace xal
 		/// @note Used usually only with streamed Sounds.
 		int bufferIndex;
 		/// @brief How many bytes have been processed during the last update.
-		int processedByteCount;
+		int64_t processedByteCount;
 		/// @brief How long this Player has been idle.
 		/// @note Used for memory cleaning.
 		float idleTime;
@@ -176,6 +187,8 @@ namespace xal
 		void _stop(float fadeTime = 0.0f);
 		/// @note This method is not thread-safe and is for internal usage only.
 		void _pause(float fadeTime = 0.0f);
+		/// @note This method is not thread-safe and is for internal usage only.
+		void _seekSamples(int64_t sample);
 
 		/// @return The current gain for the Sound depending on global gain, category gain and Player gain.
 		float _calcGain() const;
@@ -185,7 +198,7 @@ namespace xal
 		virtual inline bool _systemIsPlaying() const { return false; }
 		/// @brief Position of the playback buffer.
 		/// @note This is implemented by the audio-system.
-		virtual inline unsigned int _systemGetBufferPosition() const { return 0; }
+		virtual inline int64_t _systemGetBufferPosition() const { return 0; }
 		/// @brief Whether this implementation needs to correct the streamed buffer position.
 		/// @note This is implemented by the audio-system.
 		virtual inline bool _systemNeedsStreamedBufferPositionCorrection() const { return true; }
@@ -14,6 +14,7 @@
 #define XAL_SOUND_H
 
 #include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstring.h>
 
 #include "AudioManager.h"
@@ -24,11 +25,13 @@ namespace xal
 	class Player;
 	class Buffer;
 	class Category;
+	struct BankEntry;
 
 	/// @brief Provides audio data definition.
 	class xalExport Sound
 	{
 	public:
+		friend class AudioManager;
 		friend class Player;
 
 		/// @brief Constructor.
@@ -45,6 +48,31 @@ namespace xal
 		/// @param[in] samplingRate Sampling rate.
 		/// @param[in] bitsPerSample Bits per sample.
 		Sound(chstr name, Category* category, unsigned char* data, int size, int channels, int samplingRate, int bitsPerSample);
+		/// @brief Constructor.
+		/// @param[in] name Name of the Sound.
+		/// @param[in] category The Category where to register this Sound.
+		/// @param[in] data Raw audio data owned by the application.
+		/// @param[in] size Raw audio data byte size.
+		/// @param[in] channels Number of channels.
+		/// @param[in] samplingRate Sampling rate.
+		/// @param[in] bitsPerSample Bits per sample.
+		/// @param[in] releaseCallback Called with data and userData when the Sound is destroyed. Can be NULL.
+		/// @param[in] userData User data that is passed to the release callback.
+		Sound(chstr name, Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		/// @brief Constructor.
+		/// @param[in] name Name of the Sound.
+		/// @param[in] category The Category where to register this Sound.
+		/// @param[in] callback Callback that generates the audio data.
+		/// @param[in] userData User data that is passed to the callback.
+		/// @param[in] channels Number of channels.
+		/// @param[in] samplingRate Sampling rate.
+		/// @param[in] bitsPerSample Bits per sample.
+		Sound(chstr name, Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
+		/// @brief Constructor.
+		/// @param[in] bankEntry Entry of a sound bank.
+		/// @param[in] category The Category where to register this Sound.
+		/// @param[in] prefix Used to differentiate between Sounds that have the same filename (e.g. by using a directory path as prefix).
+		Sound(const BankEntry& bankEntry, Category* category, chstr prefix = "");
 		/// @brief Destructor.
 		~Sound();
 
@@ -54,11 +82,14 @@ namespace xal
 		HL_DEFINE_GET(hstr, filename, Filename);
 		/// @brief Gets the Category.
 		HL_DEFINE_GET(Category*, category, Category);
+		/// @brief Gets the sound bank entry.
+		/// @note This is NULL if the Sound wasn't created from a sound bank.
+		HL_DEFINE_GET(BankEntry*, bankEntry, BankEntry);
 
 		/// @return Byte-size of the audio data.
-		int getSize();
+		int64_t getSize();
 		/// @return Source byte size.
-		int getSourceSize();
+		int64_t getSourceSize();
 		/// @return Number of channels in the audio data.
 		int getChannels();
 		/// @return Sampling rate of the audio data.
@@ -67,11 +98,25 @@ namespace xal
 		int getBitsPerSample();
 		/// @return Length of the audio data in seconds.
 		float getDuration();
+		/// @return Number of bytes saved by the load-time optimization of PCM data.
+		/// @see Category::isPcmOptimized()
+		int getSavedSize();
+		/// @return Integrated loudness in LUFS as measured by the EBU R128 method.
+		/// @note Returns -70.0 if the Sound is silent or wasn't analyzed yet.
+		/// @see Category::isLoudnessAnalysisEnabled()
+		float getLoudness();
+		/// @return True peak in dBTP.
+		/// @note Returns -70.0 if the Sound is silent or wasn't analyzed yet.
+		float getTruePeak();
+		/// @return True if loudness data of the Sound is available.
+		/// @note Streamed Sounds are never analyzed.
+		bool isLoudnessAnalyzed();
 		/// @return File format of the underlying audio file.
 		Format getFormat() const;
 		/// @return Gets Buffer's idle time
 		float getBufferIdleTime();
 		/// @return True if the Sounds's Buffer accesses streamed data.
+		/// @note IMA-ADPCM data is decoded while playing so such Sounds are streamed as well.
 		bool isStreamed() const;
 		/// @return True if the Sounds's Buffer is loaded.
 		bool isLoaded();
@@ -90,6 +135,36 @@ namespace xal
 		Category* category;
 		/// @brief Buffer instance that handles decoded data.
 		Buffer* buffer;
+		/// @brief Sound bank entry where the audio data is located.
+		BankEntry* bankEntry;
+		/// @brief Whether the Buffer is only created while the Sound is used.
+		/// @note Categories that don't load any data upon Buffer creation don't need a Buffer until the first Player is created.
+		bool deferred;
+		/// @brief Number of Players that use the Buffer.
+		int playerCount;
+		/// @brief Protects the Buffer of a deferred Sound which can be released by the update thread.
+		hmutex bufferMutex;
+		/// @brief Whether the metadata of a Sound without Buffer is available.
+		bool loadedMetaData;
+		/// @brief Byte-size of the audio data when there is no Buffer.
+		int64_t size;
+		/// @brief Number of channels when there is no Buffer.
+		int channels;
+		/// @brief Sampling rate when there is no Buffer.
+		int samplingRate;
+		/// @brief Bits per sample when there is no Buffer.
+		int bitsPerSample;
+		/// @brief Duration in seconds when there is no Buffer.
+		float duration;
+
+		/// @note This method is not thread-safe and is for internal usage only.
+		void _tryLoadMetaData();
+		/// @note This method is not thread-safe and is for internal usage only.
+		Buffer* _bindPlayer();
+		/// @note This method is not thread-safe and is for internal usage only.
+		void _unbindPlayer();
+		/// @note This method is not thread-safe and is for internal usage only.
+		void _releaseBuffer();
 
 	};
 
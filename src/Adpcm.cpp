@@ -0,0 +1,170 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+
+#include "Adpcm.h"
+
+// each channel starts a block with a 4 byte header and then uses 4 byte groups of 8 samples
+#define HEADER_SIZE 4
+#define GROUP_SIZE 4
+#define GROUP_FRAMES 8
+
+namespace xal
+{
+	static const int indexTable[16] =
+	{
+		-1, -1, -1, -1, 2, 4, 6, 8,
+		-1, -1, -1, -1, 2, 4, 6, 8
+	};
+
+	static const int stepTable[89] =
+	{
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+		19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+		50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+		130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+		337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+		876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+		2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+		5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+		15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+	};
+
+	static inline int _decodeNibble(int nibble, int& predictor, int& index)
+	{
+		int step = stepTable[index];
+		int delta = step >> 3;
+		if ((nibble & 0x4) != 0)
+		{
+			delta += step;
+		}
+		if ((nibble & 0x2) != 0)
+		{
+			delta += step >> 1;
+		}
+		if ((nibble & 0x1) != 0)
+		{
+			delta += step >> 2;
+		}
+		predictor = hclamp(predictor + ((nibble & 0x8) != 0 ? -delta : delta), -32768, 32767);
+		index = hclamp(index + indexTable[nibble], 0, 88);
+		return predictor;
+	}
+
+	static inline int _encodeSample(int sample, int& predictor, int& index)
+	{
+		int step = stepTable[index];
+		int difference = sample - predictor;
+		int nibble = 0;
+		if (difference < 0)
+		{
+			nibble = 0x8;
+			difference = -difference;
+		}
+		if (difference >= step)
+		{
+			nibble |= 0x4;
+			difference -= step;
+		}
+		if (difference >= (step >> 1))
+		{
+			nibble |= 0x2;
+			difference -= (step >> 1);
+		}
+		if (difference >= (step >> 2))
+		{
+			nibble |= 0x1;
+		}
+		// the predictor has to follow exactly what the decoder will do
+		_decodeNibble(nibble, predictor, index);
+		return nibble;
+	}
+
+	int Adpcm::calcBlockFrames(int blockSize, int channels)
+	{
+		return ((blockSize - HEADER_SIZE * channels) / (GROUP_SIZE * channels) * GROUP_FRAMES + 1);
+	}
+
+	int Adpcm::calcEncodedSize(int frames, int channels, int blockSize)
+	{
+		int blockFrames = Adpcm::calcBlockFrames(blockSize, channels);
+		return ((frames + blockFrames - 1) / blockFrames * blockSize);
+	}
+
+	void Adpcm::encode(const short* input, int frames, int channels, int blockSize, unsigned char* output)
+	{
+		int blockFrames = Adpcm::calcBlockFrames(blockSize, channels);
+		int blocks = (frames + blockFrames - 1) / blockFrames;
+		memset(output, 0, blocks * blockSize);
+		unsigned char* block = NULL;
+		int start = 0;
+		int count = 0;
+		int predictor = 0;
+		int index = 0;
+		int sample = 0;
+		int position = 0;
+		// channels are encoded one after another so the encoder state stays local
+		for_iter (c, 0, channels)
+		{
+			index = 0;
+			for_iter (b, 0, blocks)
+			{
+				block = &output[b * blockSize];
+				start = b * blockFrames;
+				count = hmin(blockFrames, frames - start);
+				// the first sample of each block is stored as it is
+				predictor = input[start * channels + c];
+				block[c * HEADER_SIZE] = (unsigned char)(predictor & 0xFF);
+				block[c * HEADER_SIZE + 1] = (unsigned char)((predictor >> 8) & 0xFF);
+				block[c * HEADER_SIZE + 2] = (unsigned char)index;
+				for_iter (i, 1, blockFrames)
+				{
+					sample = (i < count ? input[(start + i) * channels + c] : 0);
+					position = (i - 1) % GROUP_FRAMES;
+					block[HEADER_SIZE * channels + ((i - 1) / GROUP_FRAMES * channels + c) * GROUP_SIZE + position / 2] |=
+						(unsigned char)(_encodeSample(sample, predictor, index) << ((position & 0x1) * 4));
+				}
+			}
+		}
+	}
+
+	int Adpcm::decodeBlock(const unsigned char* input, int size, int channels, short* output)
+	{
+		if (size < HEADER_SIZE * channels)
+		{
+			return 0;
+		}
+		int groups = (size - HEADER_SIZE * channels) / (GROUP_SIZE * channels);
+		const unsigned char* data = &input[HEADER_SIZE * channels];
+		const unsigned char* group = NULL;
+		short* samples = NULL;
+		int predictor = 0;
+		int index = 0;
+		for_iter (c, 0, channels)
+		{
+			predictor = (short)(input[c * HEADER_SIZE] | (input[c * HEADER_SIZE + 1] << 8));
+			index = hclamp((int)input[c * HEADER_SIZE + 2], 0, 88);
+			output[c] = (short)predictor;
+			for_iter (g, 0, groups)
+			{
+				group = &data[(g * channels + c) * GROUP_SIZE];
+				samples = &output[(g * GROUP_FRAMES + 1) * channels + c];
+				for_iter (i, 0, GROUP_SIZE)
+				{
+					samples[(i * 2) * channels] = (short)_decodeNibble(group[i] & 0xF, predictor, index);
+					samples[(i * 2 + 1) * channels] = (short)_decodeNibble(group[i] >> 4, predictor, index);
+				}
+			}
+		}
+		return (groups * GROUP_FRAMES + 1);
+	}
+
+}
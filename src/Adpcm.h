@@ -0,0 +1,56 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides IMA-ADPCM encoding and decoding.
+
+#ifndef XAL_ADPCM_H
+#define XAL_ADPCM_H
+
+// block size per channel used when encoding, the same as most encoders use for 44.1 kHz data
+#define ADPCM_BLOCK_SIZE_PER_CHANNEL 512
+
+#include "xalExport.h"
+
+namespace xal
+{
+	/// @note Blocks use the same layout as IMA-ADPCM WAV files so their data can be used as it is.
+	class Adpcm
+	{
+	public:
+		/// @return Number of frames in a full block.
+		static int calcBlockFrames(int blockSize, int channels);
+		/// @return Size of the encoded data.
+		static int calcEncodedSize(int frames, int channels, int blockSize);
+
+		/// @brief Encodes 16 bit PCM data.
+		/// @param[in] input Interleaved 16 bit PCM data.
+		/// @param[in] frames Number of frames.
+		/// @param[in] channels Number of channels.
+		/// @param[in] blockSize Size of one block.
+		/// @param[out] output Encoded data, has to be at least calcEncodedSize() bytes large.
+		/// @note The last block is padded with silence.
+		static void encode(const short* input, int frames, int channels, int blockSize, unsigned char* output);
+		/// @brief Decodes one block into 16 bit PCM data.
+		/// @param[in] input Block data.
+		/// @param[in] size Size of the block, can be smaller than a full block at the end of the data.
+		/// @param[in] channels Number of channels.
+		/// @param[out] output Interleaved 16 bit PCM data.
+		/// @return Number of decoded frames.
+		static int decodeBlock(const unsigned char* input, int size, int channels, short* output);
+
+	private: // prevents inheritance and instantiation
+		Adpcm() { }
+		~Adpcm() { }
+
+	};
+	
+}
+
+#endif
@@ -19,13 +19,18 @@
 #include <hltypes/hthread.h>
 
 #include "AudioManager.h"
+#include "Bank.h"
 #include "Buffer.h"
 #include "BufferAsync.h"
 #include "Category.h"
+#include "MetaDataCache.h"
 #include "NoAudio_AudioManager.h"
+#include "Pcm.h"
 #include "Player.h"
+#include "ProviderStream.h"
 #include "Sound.h"
 #include "Source.h"
+#include "Utility.h"
 #include "xal.h"
 
 #ifdef _FORMAT_FLAC
@@ -50,6 +55,7 @@ namespace xal
 		HL_ENUM_DEFINE(Format, OGG);
 		HL_ENUM_DEFINE(Format, WAV);
 		HL_ENUM_DEFINE(Format, Memory);
+		HL_ENUM_DEFINE(Format, Generated);
 		HL_ENUM_DEFINE(Format, Unknown);
 	));
 
@@ -67,6 +73,7 @@ namespace xal
 	(
 		HL_ENUM_DEFINE(SourceMode, Disk);
 		HL_ENUM_DEFINE(SourceMode, Ram);
+		HL_ENUM_DEFINE(SourceMode, Mapped);
 	));
 
 	AudioManager* manager = NULL;
@@ -80,6 +87,9 @@ namespace xal
 		globalGainFadeSpeed(-1.0f),
 		globalGainFadeTime(0.0f),
 		suspendResumeFadeTime(0.5f),
+		seekIndexEnabled(false),
+		ioProvider(NULL),
+		maxAsyncPrefetchSize(33554432), // 32 MB
 		thread(NULL),
 		threadRunning(false)
 	{
@@ -165,6 +175,11 @@ namespace xal
 			delete it->second;
 		}
 		this->categories.clear();
+		Bank::clear();
+		MetaDataCache::clear();
+#ifdef _FORMAT_OGG
+		OGG_Source::clearDecoderCache();
+#endif
 	}
 
 	float AudioManager::getGlobalGain()
@@ -330,6 +345,7 @@ namespace xal
 			{
 				(*it)->_update(timeDelta);
 			}
+			this->_releaseDeferredBuffers(false);
 		}
 		else if (this->suspendResumeFadeTime > 0.0f && this->thread != NULL)
 		{
@@ -421,6 +437,57 @@ namespace xal
 		return sound;
 	}
 
+	Sound* AudioManager::createSound(chstr name, chstr categoryName, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_createSound(name, categoryName, callback, userData, channels, samplingRate, bitsPerSample);
+	}
+
+	Sound* AudioManager::_createSound(chstr name, chstr categoryName, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample)
+	{
+		Category* category = this->_getCategory(categoryName);
+		Sound* sound = new Sound(name, category, callback, userData, channels, samplingRate, bitsPerSample);
+		if (this->sounds.hasKey(sound->getName()))
+		{
+			delete sound;
+			return NULL;
+		}
+		this->sounds[sound->getName()] = sound;
+		return sound;
+	}
+
+	Sound* AudioManager::createSound(chstr name, chstr categoryName, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_createSound(name, categoryName, data, size, channels, samplingRate, bitsPerSample, releaseCallback, userData);
+	}
+
+	Sound* AudioManager::_createSound(chstr name, chstr categoryName, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData)
+	{
+		Category* category = this->_getCategory(categoryName);
+		Sound* sound = new Sound(name, category, data, size, channels, samplingRate, bitsPerSample, releaseCallback, userData);
+		if (this->sounds.hasKey(sound->getName()))
+		{
+			delete sound;
+			return NULL;
+		}
+		this->sounds[sound->getName()] = sound;
+		return sound;
+	}
+
+	Sound* AudioManager::_createSound(const BankEntry& bankEntry, chstr prefix)
+	{
+		Category* category = this->_getCategory(bankEntry.categoryName);
+		Sound* sound = new Sound(bankEntry, category, prefix);
+		if (sound->getFormat() == Format::Unknown || this->sounds.hasKey(sound->getName()))
+		{
+			delete sound;
+			return NULL;
+		}
+		this->sounds[sound->getName()] = sound;
+		return sound;
+	}
+
 	Sound* AudioManager::getSound(chstr name)
 	{
 		hmutex::ScopeLock lock(&this->mutex);
@@ -569,6 +636,142 @@ namespace xal
 		return result;
 	}
 
+	harray<hstr> AudioManager::createSoundsFromPathAsync(chstr path, chstr prefix)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_createSoundsFromPathAsync(path, prefix);
+	}
+
+	harray<hstr> AudioManager::_createSoundsFromPathAsync(chstr path, chstr prefix)
+	{
+		harray<hstr> result;
+		harray<hstr> dirs = hrdir::directories(path, true);
+		foreach (hstr, it, dirs)
+		{
+			result += this->_createSoundsFromPathAsync((*it), hrdir::baseName(*it), prefix);
+		}
+		return result;
+	}
+
+	harray<hstr> AudioManager::createSoundsFromPathAsync(chstr path, chstr categoryName, chstr prefix)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_createSoundsFromPathAsync(path, categoryName, prefix);
+	}
+
+	harray<hstr> AudioManager::_createSoundsFromPathAsync(chstr path, chstr categoryName, chstr prefix)
+	{
+		// an async category only queues buffers upon creation so registering is cheap, reading and decoding is done by BufferAsync
+		Category* category = this->_createCategory(categoryName, BufferMode::Async, SourceMode::Disk);
+		if (category->getBufferMode() != BufferMode::Async)
+		{
+			throw Exception("Audio Manager: Category '" + categoryName + "' already exists and does not use BufferMode::Async, Sounds would be loaded synchronously!");
+		}
+		harray<hstr> result;
+		harray<hstr> files = hrdir::files(path, true);
+		Sound* sound;
+		foreach (hstr, it, files)
+		{
+			sound = this->_createSound((*it), categoryName, prefix);
+			if (sound != NULL)
+			{
+				result += sound->getName();
+			}
+		}
+		return result;
+	}
+
+	int AudioManager::getPendingAsyncLoadCount()
+	{
+		return BufferAsync::getPendingCount();
+	}
+
+	int AudioManager::getPendingAsyncLoadCount(const harray<hstr>& soundNames)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_getPendingAsyncLoadCount(soundNames);
+	}
+
+	int AudioManager::_getPendingAsyncLoadCount(const harray<hstr>& soundNames)
+	{
+		int result = 0;
+		int count = soundNames.size();
+		Sound* sound = NULL;
+		for_iter (i, 0, count)
+		{
+			// destroyed Sounds and files that failed to load will never finish loading so they aren't pending anymore
+			if (this->sounds.hasKey(soundNames[i]))
+			{
+				sound = this->sounds[soundNames[i]];
+				if (sound->buffer != NULL && sound->buffer->isAsyncLoadQueued())
+				{
+					++result;
+				}
+			}
+		}
+		return result;
+	}
+
+	bool AudioManager::waitForAsyncLoads(float timeout)
+	{
+		// not locking the manager here, BufferAsync has its own mutex and the decoder threads must not be blocked
+		float time = timeout;
+		while (time > 0.0f || timeout <= 0.0f)
+		{
+			if (BufferAsync::getPendingCount() == 0)
+			{
+				return true;
+			}
+			BufferAsync::update();
+			hthread::sleep(0.1f);
+			time -= 0.0001f;
+		}
+		return (BufferAsync::getPendingCount() == 0);
+	}
+
+	bool AudioManager::waitForAsyncLoads(const harray<hstr>& soundNames, float timeout)
+	{
+		float time = timeout;
+		while (time > 0.0f || timeout <= 0.0f)
+		{
+			if (this->getPendingAsyncLoadCount(soundNames) == 0)
+			{
+				return true;
+			}
+			BufferAsync::update();
+			hthread::sleep(0.1f);
+			time -= 0.0001f;
+		}
+		return (this->getPendingAsyncLoadCount(soundNames) == 0);
+	}
+
+	harray<hstr> AudioManager::createSoundsFromBank(chstr filename, chstr prefix)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_createSoundsFromBank(filename, prefix);
+	}
+
+	harray<hstr> AudioManager::_createSoundsFromBank(chstr filename, chstr prefix)
+	{
+		harray<hstr> result;
+		harray<BankEntry> entries;
+		if (!Bank::read(filename, entries))
+		{
+			return result;
+		}
+		Sound* sound;
+		foreach (BankEntry, it, entries)
+		{
+			this->_createCategory((*it).categoryName, BufferMode::Full, SourceMode::Mapped);
+			sound = this->_createSound((*it), prefix);
+			if (sound != NULL)
+			{
+				result += sound->getName();
+			}
+		}
+		return result;
+	}
+
 	Player* AudioManager::createPlayer(chstr soundName)
 	{
 		hmutex::ScopeLock lock(&this->mutex);
@@ -628,6 +831,27 @@ namespace xal
 		return buffer;
 	}
 
+	Buffer* AudioManager::_createBuffer(Buffer* sharedBuffer)
+	{
+		Buffer* buffer = new Buffer(sharedBuffer);
+		this->buffers += buffer;
+		return buffer;
+	}
+
+	Buffer* AudioManager::_createBuffer(Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample)
+	{
+		Buffer* buffer = new Buffer(category, callback, userData, channels, samplingRate, bitsPerSample);
+		this->buffers += buffer;
+		return buffer;
+	}
+
+	Buffer* AudioManager::_createBuffer(Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData)
+	{
+		Buffer* buffer = new Buffer(category, data, size, channels, samplingRate, bitsPerSample, releaseCallback, userData);
+		this->buffers += buffer;
+		return buffer;
+	}
+
 	void AudioManager::_destroyBuffer(Buffer* buffer)
 	{
 		this->buffers -= buffer;
@@ -919,6 +1143,26 @@ namespace xal
 			}
 		}
 		hlog::debugf(logTag, "Found %d buffers for memory clearing.", count);
+		this->_releaseDeferredBuffers(true);
+#ifdef _FORMAT_OGG
+		OGG_Source::clearDecoderCache();
+#endif
+	}
+
+	void AudioManager::_releaseDeferredBuffers(bool ignoreIdleTime)
+	{
+		// only Sounds without Players are tracked here, going backwards because _releaseBuffer alters idleDeferredSounds
+		Sound* sound = NULL;
+		Buffer* buffer = NULL;
+		for (int i = this->idleDeferredSounds.size() - 1; i >= 0; --i)
+		{
+			sound = this->idleDeferredSounds[i];
+			buffer = sound->buffer;
+			if ((ignoreIdleTime || buffer->getIdleTime() >= this->idlePlayerUnloadTime) && !buffer->isLoaded() && !buffer->isAsyncLoadQueued())
+			{
+				sound->_releaseBuffer();
+			}
+		}
 	}
 
 	void AudioManager::suspendAudio()
@@ -987,6 +1231,22 @@ namespace xal
 
 	void AudioManager::_convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSample, hstream& stream)
 	{
+		// generic audio systems cannot play float data
+		if (bitsPerSample == FLOAT_BITS_PER_SAMPLE && stream.size() > 0)
+		{
+			int count = (int)(stream.size() / sizeof(float));
+			Pcm::convertFloatToS16((float*)&stream[0], (short*)&stream[0], count);
+			stream.truncate(count * sizeof(short));
+			stream.rewind();
+		}
+	}
+
+	void AudioManager::_getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const
+	{
+		if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			bitsPerSample = 16;
+		}
 	}
 
 	void AudioManager::_suspendSystem()
@@ -997,6 +1257,32 @@ namespace xal
 	{
 	}
 
+	bool AudioManager::createSeekIndex(chstr filename)
+	{
+#ifdef _FORMAT_OGG
+		if (filename.endsWith(".ogg"))
+		{
+			return OGG_Source::createSeekIndex(filename);
+		}
+#endif
+		return false;
+	}
+
+	bool AudioManager::createBank(chstr path, chstr filename)
+	{
+		return Bank::write(path, filename);
+	}
+
+	bool AudioManager::loadMetaDataCache(chstr filename)
+	{
+		return MetaDataCache::load(filename);
+	}
+
+	bool AudioManager::saveMetaDataCache(chstr filename)
+	{
+		return MetaDataCache::save(filename);
+	}
+
 	void AudioManager::addAudioExtension(chstr extension)
 	{
 		this->extensions += extension;
@@ -1004,7 +1290,7 @@ namespace xal
 
 	hstr AudioManager::findAudioFile(chstr filename) const
 	{
-		if (hresource::exists(filename))
+		if (ProviderStream::exists(filename))
 		{
 			return hdbase::systemize(filename);
 		}
@@ -1012,7 +1298,7 @@ namespace xal
 		foreachc (hstr, it, this->extensions)
 		{
 			name = hdbase::systemize(filename + (*it));
-			if (hresource::exists(name))
+			if (ProviderStream::exists(name))
 			{
 				return name;
 			}
@@ -1023,7 +1309,7 @@ namespace xal
 			foreachc (hstr, it, this->extensions)
 			{
 				name = hdbase::systemize(newFilename + (*it));
-				if (hresource::exists(name))
+				if (ProviderStream::exists(name))
 				{
 					return name;
 				}
@@ -0,0 +1,288 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hrdir.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "AudioManager.h"
+#include "Bank.h"
+#include "Buffer.h"
+#include "MappedStream.h"
+#include "MetaDataCache.h"
+#include "Source.h"
+#include "xal.h"
+
+#define BANK_MAGIC "XBNK"
+#define BANK_VERSION 2
+#define BANK_HEADER_SIZE 16 // magic, version, number of entries, index size
+#define BANK_ENTRY_SIZE 44 // offset, file size, float output, size, channels, sampling rate, bits per sample, duration
+
+namespace xal
+{
+	harray<MappedStream*> Bank::streams;
+	hmutex Bank::streamsMutex;
+
+	static bool _readValue(const unsigned char* data, int size, int& position, void* value, int valueSize)
+	{
+		if (position + valueSize > size)
+		{
+			return false;
+		}
+		memcpy(value, &data[position], valueSize);
+		position += valueSize;
+		return true;
+	}
+
+	static bool _readString(const unsigned char* data, int size, int& position, hstr& value)
+	{
+		unsigned short length = 0;
+		if (!_readValue(data, size, position, &length, 2) || position + length > size)
+		{
+			return false;
+		}
+		value = hstr((const char*)&data[position], (int)length);
+		position += length;
+		return true;
+	}
+
+	static void _writeString(hstream& stream, chstr value)
+	{
+		unsigned short length = (unsigned short)value.size();
+		stream.writeRaw((unsigned char*)&length, 2);
+		stream.writeRaw((unsigned char*)value.cStr(), length);
+	}
+
+	bool Bank::read(chstr filename, harray<BankEntry>& entries)
+	{
+		hmutex::ScopeLock lock(&Bank::streamsMutex);
+		MappedStream* stream = NULL;
+		foreach (MappedStream*, it, Bank::streams)
+		{
+			if ((*it)->getFilename() == filename)
+			{
+				stream = (*it);
+				break;
+			}
+		}
+		if (stream == NULL)
+		{
+			stream = new MappedStream();
+			if (stream->open(filename))
+			{
+				Bank::streams += stream;
+			}
+			else
+			{
+				delete stream;
+				stream = NULL;
+			}
+		}
+		if (stream != NULL)
+		{
+			stream->rewind();
+			return Bank::_readIndex(*stream, filename, entries);
+		}
+		// banks that cannot be mapped (e.g. inside archives) are read normally, Sounds will copy their data to RAM then
+		if (!hresource::exists(filename))
+		{
+			hlog::error(logTag, "Unable to open: " + filename);
+			return false;
+		}
+		hresource resource;
+		resource.open(filename);
+		return Bank::_readIndex(resource, filename, entries);
+	}
+
+	bool Bank::_readIndex(hsbase& stream, chstr filename, harray<BankEntry>& entries)
+	{
+		unsigned char header[BANK_HEADER_SIZE];
+		if (stream.readRaw(header, BANK_HEADER_SIZE) != BANK_HEADER_SIZE || memcmp(header, BANK_MAGIC, 4) != 0)
+		{
+			hlog::error(logTag, "Not a sound bank: " + filename);
+			return false;
+		}
+		int version = 0;
+		int count = 0;
+		int indexSize = 0;
+		memcpy(&version, &header[4], 4);
+		memcpy(&count, &header[8], 4);
+		memcpy(&indexSize, &header[12], 4);
+		if (version != BANK_VERSION || count < 0 || indexSize < 0)
+		{
+			hlog::errorf(logTag, "Unsupported sound bank version %d: %s", version, filename.cStr());
+			return false;
+		}
+		// the whole index is read at once, the audio data stays untouched
+		unsigned char* data = new unsigned char[hmax(indexSize, 1)];
+		if (stream.readRaw(data, indexSize) != indexSize)
+		{
+			delete[] data;
+			hlog::error(logTag, "Sound bank index is incomplete: " + filename);
+			return false;
+		}
+		int64_t bankSize = stream.size();
+		int position = 0;
+		BankEntry entry;
+		entry.bankFilename = filename;
+		int floatOutput = 0;
+		bool success = true;
+		for_iter (i, 0, count)
+		{
+			success = (_readString(data, indexSize, position, entry.filename) &&
+				_readString(data, indexSize, position, entry.categoryName) &&
+				_readValue(data, indexSize, position, &entry.offset, 8) &&
+				_readValue(data, indexSize, position, &entry.fileSize, 8) &&
+				_readValue(data, indexSize, position, &floatOutput, 4) &&
+				_readValue(data, indexSize, position, &entry.size, 8) &&
+				_readValue(data, indexSize, position, &entry.channels, 4) &&
+				_readValue(data, indexSize, position, &entry.samplingRate, 4) &&
+				_readValue(data, indexSize, position, &entry.bitsPerSample, 4) &&
+				_readValue(data, indexSize, position, &entry.duration, 4));
+			if (!success || entry.offset < 0 || entry.fileSize < 0 || entry.offset + entry.fileSize > bankSize)
+			{
+				hlog::error(logTag, "Sound bank index is corrupt: " + filename);
+				success = false;
+				break;
+			}
+			entry.floatOutput = (floatOutput != 0);
+			entries += entry;
+		}
+		delete[] data;
+		return success;
+	}
+
+	bool Bank::write(chstr path, chstr filename)
+	{
+		harray<BankEntry> entries;
+		harray<hstr> files;
+		BankEntry entry;
+		entry.offset = 0;
+		// the sample format of some sources depends on whether the audio system mixes float data
+		entry.floatOutput = MetaDataCache::isFloatOutput();
+		int floatOutput = (entry.floatOutput ? 1 : 0);
+		harray<hstr> dirs = hrdir::directories(path, true);
+		harray<hstr> dirFiles;
+		Format format = Format::Unknown;
+		Source* source = NULL;
+		foreach (hstr, it, dirs)
+		{
+			dirFiles = hrdir::files((*it), true);
+			foreach (hstr, it2, dirFiles)
+			{
+				format = Buffer::findFormat(*it2);
+				if (format == Format::Unknown)
+				{
+					continue;
+				}
+				// metadata is probed once when packing so loading the bank doesn't have to open any audio data
+				source = xal::manager->_createSource((*it2), SourceMode::Disk, BufferMode::Full, format);
+				if (!source->open())
+				{
+					delete source;
+					hlog::warn(logTag, "Skipping file that cannot be opened: " + (*it2));
+					continue;
+				}
+				entry.categoryName = hrdir::baseName(*it);
+				entry.filename = hrdir::joinPath(entry.categoryName, hrdir::baseName(*it2));
+				entry.fileSize = hresource::hinfo(*it2).size;
+				entry.size = source->getSize();
+				entry.channels = source->getChannels();
+				entry.samplingRate = source->getSamplingRate();
+				entry.bitsPerSample = source->getBitsPerSample();
+				entry.duration = source->getDuration();
+				source->close();
+				delete source;
+				entries += entry;
+				files += (*it2);
+			}
+		}
+		int indexSize = 0;
+		foreach (BankEntry, it, entries)
+		{
+			indexSize += 2 + (*it).filename.size() + 2 + (*it).categoryName.size() + BANK_ENTRY_SIZE;
+		}
+		hstream data;
+		unsigned char header[BANK_HEADER_SIZE];
+		int version = BANK_VERSION;
+		int count = entries.size();
+		memcpy(header, BANK_MAGIC, 4);
+		memcpy(&header[4], &version, 4);
+		memcpy(&header[8], &count, 4);
+		memcpy(&header[12], &indexSize, 4);
+		data.writeRaw(header, BANK_HEADER_SIZE);
+		int64_t offset = BANK_HEADER_SIZE + indexSize;
+		foreach (BankEntry, it, entries)
+		{
+			(*it).offset = offset;
+			offset += (*it).fileSize;
+			_writeString(data, (*it).filename);
+			_writeString(data, (*it).categoryName);
+			data.writeRaw((unsigned char*)&(*it).offset, 8);
+			data.writeRaw((unsigned char*)&(*it).fileSize, 8);
+			data.writeRaw((unsigned char*)&floatOutput, 4);
+			data.writeRaw((unsigned char*)&(*it).size, 8);
+			data.writeRaw((unsigned char*)&(*it).channels, 4);
+			data.writeRaw((unsigned char*)&(*it).samplingRate, 4);
+			data.writeRaw((unsigned char*)&(*it).bitsPerSample, 4);
+			data.writeRaw((unsigned char*)&(*it).duration, 4);
+		}
+		data.rewind();
+		try
+		{
+			hfile file;
+			file.open(filename, hfaccess::Write);
+			file.writeRaw(data);
+			// the audio files are stored as they are so the usual sources can decode them
+			hstream payload;
+			for_iter (i, 0, files.size())
+			{
+				hresource resource;
+				resource.open(files[i]);
+				payload.clear();
+				payload.writeRaw(resource);
+				payload.rewind();
+				if (payload.size() != entries[i].fileSize)
+				{
+					hlog::error(logTag, "File changed while packing sound bank: " + files[i]);
+					file.close();
+					return false;
+				}
+				file.writeRaw(payload);
+			}
+			file.close();
+		}
+		catch (hexception& e)
+		{
+			hlog::error(logTag, "Could not write sound bank: " + e.getMessage());
+			return false;
+		}
+		hlog::writef(logTag, "Packed %d files into sound bank: %s", entries.size(), filename.cStr());
+		return true;
+	}
+
+	void Bank::clear()
+	{
+		hmutex::ScopeLock lock(&Bank::streamsMutex);
+		foreach (MappedStream*, it, Bank::streams)
+		{
+			delete (*it);
+		}
+		Bank::streams.clear();
+	}
+	
+}
@@ -0,0 +1,76 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides reading and writing of sound bank files.
+
+#ifndef XAL_BANK_H
+#define XAL_BANK_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	class MappedStream;
+
+	struct BankEntry
+	{
+		hstr bankFilename;
+		hstr filename;
+		hstr categoryName;
+		int64_t offset;
+		int64_t fileSize;
+		bool floatOutput;
+		int64_t size;
+		int channels;
+		int samplingRate;
+		int bitsPerSample;
+		float duration;
+	};
+
+	/// @note Banks contain an index with pre-probed metadata followed by the unchanged audio files.
+	/// @note The metadata is only used if it was probed with an audio system that uses the same sample format, otherwise it's probed again.
+	class Bank
+	{
+	public:
+		/// @brief Reads the index of a bank file.
+		/// @param[in] filename Filename of the bank.
+		/// @param[out] entries Entries of the bank.
+		/// @return True if the bank was read successfully.
+		/// @note The bank stays mapped until clear() is called so its Sounds can access the data without mapping it again.
+		static bool read(chstr filename, harray<BankEntry>& entries);
+		/// @brief Packs all audio files in a path into a bank file.
+		/// @param[in] path Path where the directories are located.
+		/// @param[in] filename Filename of the bank.
+		/// @return True if the bank was written successfully.
+		/// @note The base-name of each directory located in path is used as Category name like in AudioManager::createSoundsFromPath().
+		static bool write(chstr path, chstr filename);
+		/// @brief Unmaps all banks that aren't in use anymore.
+		static void clear();
+
+	protected:
+		static harray<MappedStream*> streams;
+		static hmutex streamsMutex;
+
+		static bool _readIndex(hsbase& stream, chstr filename, harray<BankEntry>& entries);
+
+	private: // prevents inheritance and instantiation
+		Bank() { }
+		~Bank() { }
+
+	};
+	
+}
+
+#endif
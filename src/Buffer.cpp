@@ -6,40 +6,111 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <math.h>
 #include <string.h> // required on Unix because of memset usage
 
 #include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hresource.h>
 #include <hltypes/hstring.h>
 
+#include "Adpcm.h"
+#include "ADPCM_Source.h"
 #include "AudioManager.h"
+#include "Bank.h"
 #include "Buffer.h"
 #include "BufferAsync.h"
 #include "Category.h"
+#include "Generator_Source.h"
+#include "LoudnessMeter.h"
+#include "Memory_Source.h"
+#include "MetaDataCache.h"
+#include "Pcm.h"
+#include "ProviderStream.h"
+#include "Resampler.h"
 #include "Sound.h"
 #include "Source.h"
 #include "xal.h"
 
+#define PCM_CACHE_EXTENSION ".xalpcm"
+#define PCM_CACHE_VERSION 2
+#define PCM_CACHE_HEADER_SIZE 52
+#define PCM_CACHE_HASH_BLOCK_SIZE 65536
+#define PCM_CACHE_COPY_BLOCK_SIZE 16777216
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
 namespace xal
 {
 	Buffer::Buffer(Sound* sound)
 	{
 		this->filename = sound->getFilename();
-		this->fileSize = (int)hresource::hinfo(this->filename).size;
-		Category* category = sound->getCategory();
-		this->mode = category->getBufferMode();
+		BankEntry* bankEntry = sound->getBankEntry();
+		this->fileSize = 0;
+		this->modificationTime = 0;
+		if (bankEntry == NULL)
+		{
+			Buffer::findFileInfo(this->filename, this->fileSize, this->modificationTime);
+		}
+		else
+		{
+			this->fileSize = bankEntry->fileSize;
+		}
+		this->category = sound->getCategory();
+		this->mode = this->category->getBufferMode();
 		this->loaded = false;
 		this->asyncLoadQueued = false;
 		this->asyncLoadDiscarded = false;
-		this->source = xal::manager->_createSource(this->filename, category->getSourceMode(), this->mode, this->getFormat());
+		// sounds from a bank always access the already mapped bank
+		this->source = xal::manager->_createSource(this->filename, (bankEntry == NULL ? this->category->getSourceMode() : SourceMode::Mapped), this->mode, this->getFormat());
 		this->loadedMetaData = false;
 		this->size = 0;
 		this->channels = 2;
 		this->samplingRate = 44100;
 		this->bitsPerSample = 16;
 		this->duration = 0.0f;
+		this->savedSize = 0;
+		this->loudnessAnalyzed = false;
+		this->loudness = LOUDNESS_MINIMUM;
+		this->truePeak = LOUDNESS_MINIMUM;
 		this->idleTime = 0.0f;
+		this->adpcm = (this->category->isAdpcmStorage() && this->mode != BufferMode::Streamed && this->source != NULL);
+		this->adpcmBlockSize = 0;
+		this->sharedBuffer = NULL;
+		if (this->source != NULL)
+		{
+			this->source->setModificationTime(this->modificationTime);
+		}
+		if (bankEntry != NULL)
+		{
+			this->source->setBankRange(bankEntry->bankFilename, bankEntry->offset, bankEntry->fileSize);
+			// metadata was probed when the bank was packed, but sources provide a different sample format if that audio system mixed differently
+			if (bankEntry->floatOutput == MetaDataCache::isFloatOutput())
+			{
+				this->size = bankEntry->size;
+				this->channels = bankEntry->channels;
+				this->samplingRate = bankEntry->samplingRate;
+				this->bitsPerSample = bankEntry->bitsPerSample;
+				this->duration = bankEntry->duration;
+				this->loadedMetaData = true;
+			}
+		}
+		else
+		{
+			MetaData metaData;
+			if (MetaDataCache::find(this->filename, this->fileSize, this->modificationTime, metaData))
+			{
+				this->size = metaData.size;
+				this->channels = metaData.channels;
+				this->samplingRate = metaData.samplingRate;
+				this->bitsPerSample = metaData.bitsPerSample;
+				this->duration = metaData.duration;
+				this->loadedMetaData = true;
+			}
+		}
 		if (xal::manager->isEnabled() && this->getFormat() != Format::Unknown)
 		{
 			if (this->mode == BufferMode::Full)
@@ -57,6 +128,8 @@ namespace xal
 	{
 		this->stream.writeRaw(data, size);
 		this->fileSize = size;
+		this->modificationTime = 0;
+		this->category = category;
 		this->mode = BufferMode::Full;
 		this->loaded = true;
 		this->asyncLoadQueued = false;
@@ -68,7 +141,97 @@ namespace xal
 		this->samplingRate = samplingRate;
 		this->bitsPerSample = bitsPerSample;
 		this->duration = (float)size / (samplingRate * channels * bitsPerSample / 8);
+		this->savedSize = 0;
+		this->loudnessAnalyzed = false;
+		this->loudness = LOUDNESS_MINIMUM;
+		this->truePeak = LOUDNESS_MINIMUM;
+		this->idleTime = 0.0f;
+		this->adpcm = false;
+		this->adpcmBlockSize = 0;
+		this->sharedBuffer = NULL;
+	}
+
+	Buffer::Buffer(Buffer* sharedBuffer)
+	{
+		// streams the IMA-ADPCM data of a shared buffer so each player can decode it separately
+		this->filename = sharedBuffer->filename;
+		this->fileSize = sharedBuffer->fileSize;
+		this->modificationTime = sharedBuffer->modificationTime;
+		this->category = sharedBuffer->category;
+		this->mode = BufferMode::Streamed;
+		this->loaded = false;
+		this->asyncLoadQueued = false;
+		this->asyncLoadDiscarded = false;
+		this->source = new ADPCM_Source(sharedBuffer);
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
+		this->savedSize = 0;
+		this->loudnessAnalyzed = false;
+		this->loudness = LOUDNESS_MINIMUM;
+		this->truePeak = LOUDNESS_MINIMUM;
+		this->idleTime = 0.0f;
+		this->adpcm = false;
+		this->adpcmBlockSize = 0;
+		this->sharedBuffer = sharedBuffer;
+	}
+
+	Buffer::Buffer(Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData)
+	{
+		// the data isn't copied, every Player streams it directly from the application's memory
+		this->filename = "";
+		this->fileSize = size;
+		this->modificationTime = 0;
+		this->category = category;
+		this->mode = BufferMode::Streamed;
+		this->loaded = false;
+		this->asyncLoadQueued = false;
+		this->asyncLoadDiscarded = false;
+		this->source = new Memory_Source(data, size, channels, samplingRate, bitsPerSample, releaseCallback, userData);
+		this->loadedMetaData = true;
+		this->size = size;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = bitsPerSample;
+		this->duration = this->source->getDuration();
+		this->savedSize = 0;
+		this->loudnessAnalyzed = false;
+		this->loudness = LOUDNESS_MINIMUM;
+		this->truePeak = LOUDNESS_MINIMUM;
+		this->idleTime = 0.0f;
+		this->adpcm = false;
+		this->adpcmBlockSize = 0;
+		this->sharedBuffer = NULL;
+	}
+
+	Buffer::Buffer(Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample)
+	{
+		this->filename = "";
+		this->fileSize = 0;
+		this->modificationTime = 0;
+		this->category = category;
+		this->mode = BufferMode::Streamed;
+		this->loaded = false;
+		this->asyncLoadQueued = false;
+		this->asyncLoadDiscarded = false;
+		this->source = new Generator_Source(callback, userData, channels, samplingRate, bitsPerSample);
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = bitsPerSample;
+		this->duration = 0.0f;
+		this->savedSize = 0;
+		this->loudnessAnalyzed = false;
+		this->loudness = LOUDNESS_MINIMUM;
+		this->truePeak = LOUDNESS_MINIMUM;
 		this->idleTime = 0.0f;
+		this->adpcm = false;
+		this->adpcmBlockSize = 0;
+		this->sharedBuffer = NULL;
 	}
 
 	Buffer::~Buffer()
@@ -83,7 +246,7 @@ namespace xal
 		}
 	}
 	
-	int Buffer::getSize()
+	int64_t Buffer::getSize()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		this->_tryLoadMetaData();
@@ -118,38 +281,69 @@ namespace xal
 		return this->duration;
 	}
 
+	int Buffer::getSavedSize()
+	{
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->savedSize;
+	}
+
+	float Buffer::getLoudness()
+	{
+		if (this->sharedBuffer != NULL) // the data is only analyzed in the shared buffer
+		{
+			return this->sharedBuffer->getLoudness();
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->loudness;
+	}
+
+	float Buffer::getTruePeak()
+	{
+		if (this->sharedBuffer != NULL) // the data is only analyzed in the shared buffer
+		{
+			return this->sharedBuffer->getTruePeak();
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->truePeak;
+	}
+
 	Format Buffer::getFormat() const
 	{
-		if (this->filename == "" && this->source == NULL)
+		if (this->filename == "")
 		{
-			return Format::Memory;
+			return ((this->source == NULL || dynamic_cast<Memory_Source*>(this->source) != NULL) ? Format::Memory : Format::Generated);
 		}
+		return Buffer::findFormat(this->filename);
+	}
+
+	Format Buffer::findFormat(chstr filename)
+	{
 #ifdef _FORMAT_FLAC
-		if (this->filename.endsWith(".flac"))
+		if (filename.endsWith(".flac"))
 		{
 			return Format::FLAC;
 		}
 #endif
 #ifdef _FORMAT_M4A
-		if (this->filename.endsWith(".m4a"))
+		if (filename.endsWith(".m4a"))
 		{
 			return Format::M4A;
 		}
 #endif
 #ifdef _FORMAT_OGG
-		if (this->filename.endsWith(".ogg"))
+		if (filename.endsWith(".ogg"))
 		{
 			return Format::OGG;
 		}
 #endif
 #ifdef _FORMAT_SPX
-		if (this->filename.endsWith(".spx"))
+		if (filename.endsWith(".spx"))
 		{
 			return Format::SPX;
 		}
 #endif
 #ifdef _FORMAT_WAV
-		if (this->filename.endsWith(".wav"))
+		if (filename.endsWith(".wav"))
 		{
 			return Format::WAV;
 		}
@@ -157,12 +351,43 @@ namespace xal
 		return Format::Unknown;
 	}
 
+	void Buffer::findFileInfo(chstr filename, int64_t& fileSize, int64_t& modificationTime)
+	{
+		fileSize = 0;
+		modificationTime = 0;
+		if (xal::manager->getIoProvider() == NULL)
+		{
+			hinfo info = hresource::hinfo(filename);
+			fileSize = info.size;
+			modificationTime = info.modificationTime;
+		}
+		else // files of an IoProvider have no modification time so the size has to be enough
+		{
+			hsbase* stream = ProviderStream::create(filename);
+			if (stream != NULL)
+			{
+				fileSize = stream->size();
+				delete stream;
+			}
+		}
+	}
+
 	bool Buffer::isLoaded()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		return this->loaded;
 	}
 
+	bool Buffer::isLoudnessAnalyzed()
+	{
+		if (this->sharedBuffer != NULL) // the data is only analyzed in the shared buffer
+		{
+			return this->sharedBuffer->isLoudnessAnalyzed();
+		}
+		hmutex::ScopeLock lock(&this->asyncLoadMutex);
+		return this->loudnessAnalyzed;
+	}
+
 	bool Buffer::isAsyncLoadQueued()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
@@ -179,6 +404,11 @@ namespace xal
 		return (this->mode == BufferMode::Managed);
 	}
 
+	bool Buffer::isAdpcm() const
+	{
+		return this->adpcm;
+	}
+
 	void Buffer::prepare()
 	{
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
@@ -202,10 +432,8 @@ namespace xal
 		{
 			this->loaded = true;
 			this->source->open();
-			this->stream.clear(this->source->getSize());
-			this->source->load(this->stream);
+			this->_loadData();
 			this->source->close();
-			xal::manager->_convertStream(this->source, this->stream);
 			return;
 		}
 		lock.release();
@@ -259,7 +487,7 @@ namespace xal
 					// if stream isn't empty, fill the rest with silence so systems that depend on same-sized chunks don't get messed up
 					if (this->stream.size() > 0)
 					{
-						this->stream.fill(0, size);
+						this->stream.fill((this->source->getBitsPerSample() == 8 ? 0x80 : 0), size); // 8-bit data is unsigned
 						this->stream.truncate(read);
 					}
 				}
@@ -287,10 +515,18 @@ namespace xal
 	void Buffer::bind(Player* player, bool playerPaused)
 	{
 		this->boundPlayers |= player;
+		if (this->sharedBuffer != NULL)
+		{
+			this->sharedBuffer->bind(player, playerPaused);
+		}
 	}
 
 	void Buffer::unbind(Player* player, bool playerPaused)
 	{
+		if (this->sharedBuffer != NULL)
+		{
+			this->sharedBuffer->unbind(player, playerPaused);
+		}
 		if (!playerPaused)
 		{
 			this->boundPlayers /= player;
@@ -318,6 +554,10 @@ namespace xal
 	void Buffer::keepLoaded()
 	{
 		this->idleTime = 0.0f;
+		if (this->sharedBuffer != NULL)
+		{
+			this->sharedBuffer->keepLoaded();
+		}
 	}
 
 	void Buffer::rewind()
@@ -332,16 +572,35 @@ namespace xal
 		}
 	}
 
-	int Buffer::calcOutputSize(int size)
+	bool Buffer::seek(int64_t sample)
+	{
+		// fully loaded data is accessed by the audio-system directly so only streamed data can be seeked here
+		if (!this->isStreamed() || this->source == NULL || !this->source->isOpen())
+		{
+			return false;
+		}
+		return this->source->seek(sample);
+	}
+
+	int64_t Buffer::calcOutputSize(int64_t size)
 	{
-		return hround((float)size * xal::manager->getSamplingRate() * xal::manager->getChannels() * xal::manager->getBitsPerSample() /
-			((float)this->getSamplingRate() * this->getChannels() * this->getBitsPerSample()));
+		int channels = this->getChannels();
+		int samplingRate = this->getSamplingRate();
+		int bitsPerSample = this->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		// double precision keeps sizes of long streams exact
+		return (int64_t)((double)size * samplingRate * channels * bitsPerSample /
+			((double)this->getSamplingRate() * this->getChannels() * this->getBitsPerSample()) + 0.5);
 	}
 
-	int Buffer::calcInputSize(int size)
+	int64_t Buffer::calcInputSize(int64_t size)
 	{
-		return hround((float)size * this->getSamplingRate() * this->getChannels() * this->getBitsPerSample() /
-			((float)xal::manager->getSamplingRate() * xal::manager->getChannels() * xal::manager->getBitsPerSample()));
+		int channels = this->getChannels();
+		int samplingRate = this->getSamplingRate();
+		int bitsPerSample = this->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		return (int64_t)((double)size * this->getSamplingRate() * this->getChannels() * this->getBitsPerSample() /
+			((double)samplingRate * channels * bitsPerSample) + 0.5);
 	}
 
 	void Buffer::readPcmData(hstream& output)
@@ -350,17 +609,540 @@ namespace xal
 		if (this->getFormat() != Format::Unknown)
 		{
 			Source* source = xal::manager->_createSource(this->filename, SourceMode::Disk, BufferMode::Full, this->getFormat());
+			source->setModificationTime(this->modificationTime);
 			source->open();
 			if (source->getSize() > 0)
 			{
-				source->load(output);
-				xal::manager->_convertStream(source, output);
+				this->_decode(source, output, false);
 			}
 			source->close();
 			delete source;
 		}
 	}
 
+	void Buffer::_loadData()
+	{
+		bool analyzeLoudness = this->_needsLoudnessAnalysis();
+		this->savedSize = 0;
+		this->adpcmBlockSize = 0;
+		if (this->adpcm && !analyzeLoudness && this->source->getAdpcmBlockSize() > 0)
+		{
+			// data that is already IMA-ADPCM is kept as it is, it doesn't even have to be decoded
+			this->_tryLoadMetaData();
+			this->stream.clear();
+			if (this->source->loadAdpcm(this->stream))
+			{
+				this->adpcmBlockSize = this->source->getAdpcmBlockSize();
+				this->savedSize = (int)hmax(this->size - this->stream.size(), (int64_t)0);
+			}
+			return;
+		}
+		hstr cacheFilename = this->_getPcmCacheFilename();
+		if (cacheFilename == "" || !this->_readPcmCache(cacheFilename, analyzeLoudness))
+		{
+			this->_decode(this->source, this->stream, analyzeLoudness);
+			if (cacheFilename != "")
+			{
+				this->_writePcmCache(cacheFilename);
+			}
+		}
+		this->_optimizePcmData();
+		if (this->adpcm)
+		{
+			this->_encodeAdpcm();
+		}
+	}
+
+	void Buffer::_decode(Source* source, hstream& output, bool analyzeLoudness)
+	{
+		int channels = source->getChannels();
+		int samplingRate = source->getSamplingRate();
+		int bitsPerSample = source->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		bool converted = (channels != source->getChannels() || samplingRate != source->getSamplingRate() || bitsPerSample != source->getBitsPerSample());
+		if (!converted && !analyzeLoudness)
+		{
+			// no further processing required, the decoder can write directly into the final storage
+			output.clear(source->getSize());
+			source->load(output);
+			return;
+		}
+		hlog::write(logTag, "Loading file: " + source->getFilename());
+		// each decoded block is processed right away while it's still in the cache so the unconverted data never has to be kept in full
+		int frameSize = source->getChannels() * source->getBitsPerSample() / 8;
+		int blockSize = hmax(STREAM_BUFFER_SIZE / frameSize, 1) * frameSize;
+		int convertedFrameSize = channels * bitsPerSample / 8;
+		bool resampled = (samplingRate != source->getSamplingRate());
+		LoudnessMeter* meter = (analyzeLoudness ? new LoudnessMeter(channels, samplingRate) : NULL);
+		if (resampled && (!Resampler::isSupported(source->getBitsPerSample()) || !Resampler::isSupported(bitsPerSample)))
+		{
+			// the audio system's converter has no state between calls so separately converted blocks would click at their edges
+			output.clear(source->getSize());
+			source->load(output);
+			xal::manager->_convertStream(source, output);
+			if (meter != NULL && output.size() > 0)
+			{
+				meter->process((unsigned char*)output, (int)(output.size() / convertedFrameSize), bitsPerSample);
+			}
+		}
+		else
+		{
+			output.clear((int64_t)((double)source->getSize() * samplingRate * channels * bitsPerSample /
+				((double)source->getSamplingRate() * source->getChannels() * source->getBitsPerSample()) + 0.5));
+			// the resampler keeps the input its kernel still needs between blocks so they can be converted one by one
+			Resampler* resampler = (resampled ? new Resampler(source->getChannels(), source->getSamplingRate(), samplingRate) : NULL);
+			hstream input;
+			hstream block;
+			int read = 0;
+			do
+			{
+				if (resampler != NULL)
+				{
+					input.clear(blockSize);
+					read = source->loadChunk(input, blockSize);
+					block.clear(blockSize);
+					if (read > 0)
+					{
+						resampler->process((unsigned char*)input, read / frameSize, source->getBitsPerSample(), block, bitsPerSample);
+					}
+					if (read < blockSize)
+					{
+						resampler->flush(block, bitsPerSample);
+					}
+					block.rewind();
+					// only the channels are left to convert
+					xal::manager->_convertStream(source->getFilename(), source->getChannels(), samplingRate, bitsPerSample, block);
+					if (meter != NULL && block.size() > 0)
+					{
+						meter->process((unsigned char*)block, (int)block.size() / convertedFrameSize, bitsPerSample);
+					}
+					output.writeRaw(block);
+				}
+				else if (converted)
+				{
+					block.clear(blockSize);
+					read = source->loadChunk(block, blockSize);
+					if (read <= 0)
+					{
+						break;
+					}
+					xal::manager->_convertStream(source, block);
+					if (meter != NULL && block.size() > 0)
+					{
+						meter->process((unsigned char*)block, (int)block.size() / convertedFrameSize, bitsPerSample);
+					}
+					output.writeRaw(block);
+				}
+				else
+				{
+					read = source->loadChunk(output, blockSize);
+					if (read <= 0)
+					{
+						break;
+					}
+					if (meter != NULL)
+					{
+						meter->process(&output[(int)output.position()], read / frameSize, bitsPerSample);
+					}
+					output.seek(read);
+				}
+			} while (read == blockSize);
+			if (resampler != NULL)
+			{
+				delete resampler;
+			}
+		}
+		output.rewind();
+		if (meter != NULL)
+		{
+			// results are kept for the lifetime of the Buffer so reloading doesn't analyze the data again
+			this->loudness = meter->getIntegratedLoudness();
+			this->truePeak = meter->getTruePeak();
+			this->loudnessAnalyzed = true;
+			delete meter;
+			hlog::debugf(logTag, "Loudness of %s: %.1f LUFS, %.1f dBTP", source->getFilename().cStr(), this->loudness, this->truePeak);
+		}
+	}
+
+	// FNV-1a, continues from the given hash so several calls can be chained
+	static void _hashBytes(const unsigned char* data, int size, uint64_t& hash)
+	{
+		for_iter (i, 0, size)
+		{
+			hash = (hash ^ data[i]) * FNV_PRIME;
+		}
+	}
+
+	static bool _hashData(hsbase& stream, int64_t offset, int64_t size, uint64_t& hash)
+	{
+		hash = FNV_OFFSET_BASIS;
+		try
+		{
+			if (size < 0)
+			{
+				size = stream.size() - offset;
+			}
+			stream.seek(offset, hseek::Start);
+			unsigned char* block = new unsigned char[PCM_CACHE_HASH_BLOCK_SIZE];
+			int read = 0;
+			while (size > 0)
+			{
+				read = stream.readRaw(block, (int)hmin(size, (int64_t)PCM_CACHE_HASH_BLOCK_SIZE));
+				if (read <= 0)
+				{
+					break;
+				}
+				_hashBytes(block, read, hash);
+				size -= read;
+			}
+			delete[] block;
+			return (size == 0);
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not hash audio data for PCM cache: " + e.getMessage());
+		}
+		return false;
+	}
+
+	bool Buffer::_hashSourceData(uint64_t& hash)
+	{
+		if (this->source->getBankFilename() != "")
+		{
+			hresource resource;
+			try
+			{
+				resource.open(this->source->getBankFilename());
+			}
+			catch (hexception& e)
+			{
+				hlog::warn(logTag, "Could not hash audio data for PCM cache: " + e.getMessage());
+				return false;
+			}
+			return _hashData(resource, this->source->getBankOffset(), this->source->getBankSize(), hash);
+		}
+		hsbase* stream = ProviderStream::create(this->filename);
+		if (stream == NULL)
+		{
+			return false;
+		}
+		bool result = _hashData(*stream, 0, -1, hash);
+		delete stream;
+		return result;
+	}
+
+	hstr Buffer::_getPcmCacheFilename()
+	{
+		hstr path = xal::manager->getPcmCachePath();
+		if (path == "" || this->source == NULL || this->sharedBuffer != NULL || this->filename == "")
+		{
+			return "";
+		}
+		Format format = this->getFormat();
+		if (format == Format::Generated || format == Format::Unknown)
+		{
+			return "";
+		}
+		int channels = this->source->getChannels();
+		int samplingRate = this->source->getSamplingRate();
+		int bitsPerSample = this->source->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		// plain PCM that doesn't need conversion can be read as fast as a cache file
+		if (format == Format::WAV && channels == this->source->getChannels() && samplingRate == this->source->getSamplingRate() && bitsPerSample == this->source->getBitsPerSample())
+		{
+			return "";
+		}
+		// the name only identifies the asset, whether the entry is still valid is decided by the header
+		hstr identity = this->filename;
+		if (this->source->getBankFilename() != "")
+		{
+			identity = hsprintf("%s:%lld", this->source->getBankFilename().cStr(), (long long)this->source->getBankOffset());
+		}
+		uint64_t hash = FNV_OFFSET_BASIS;
+		_hashBytes((const unsigned char*)identity.cStr(), identity.size(), hash);
+		return hdir::joinPath(path, hsprintf("%016llx_%d_%d_%d", (unsigned long long)hash, channels, samplingRate, bitsPerSample) + PCM_CACHE_EXTENSION);
+	}
+
+	bool Buffer::_readPcmCache(chstr cacheFilename, bool analyzeLoudness)
+	{
+		if (!hfile::exists(cacheFilename))
+		{
+			return false;
+		}
+		unsigned char header[PCM_CACHE_HEADER_SIZE];
+		int version = 0;
+		int64_t size = 0;
+		int loudnessAnalyzed = 0;
+		float loudness = LOUDNESS_MINIMUM;
+		float truePeak = LOUDNESS_MINIMUM;
+		int64_t fileSize = 0;
+		int64_t modificationTime = 0;
+		uint64_t contentHash = 0;
+		uint64_t hash = 0;
+		int64_t remaining = 0;
+		int written = 0;
+		hfile file;
+		try
+		{
+			// entries are always copied into the stream completely so they are simply read in large blocks
+			file.open(cacheFilename);
+			if (file.readRaw(header, PCM_CACHE_HEADER_SIZE) != PCM_CACHE_HEADER_SIZE || memcmp(header, "XPCM", 4) != 0)
+			{
+				return false;
+			}
+			memcpy(&version, &header[4], 4);
+			memcpy(&size, &header[8], 8);
+			memcpy(&loudnessAnalyzed, &header[16], 4);
+			memcpy(&loudness, &header[20], 4);
+			memcpy(&truePeak, &header[24], 4);
+			memcpy(&fileSize, &header[28], 8);
+			memcpy(&modificationTime, &header[36], 8);
+			memcpy(&contentHash, &header[44], 8);
+			// an entry without loudness data can't be used when an analysis is required, it's replaced after decoding
+			if (version != PCM_CACHE_VERSION || size != file.size() - PCM_CACHE_HEADER_SIZE || fileSize != this->fileSize || (analyzeLoudness && loudnessAnalyzed == 0))
+			{
+				return false;
+			}
+			// the data only has to be hashed when the modification time can't confirm that the entry is still valid (e.g. redeployed assets or banks)
+			if ((this->modificationTime == 0 || modificationTime != this->modificationTime) && (!this->_hashSourceData(hash) || hash != contentHash))
+			{
+				return false;
+			}
+			this->stream.clear(size);
+			remaining = size;
+			while (remaining > 0)
+			{
+				written = this->stream.writeRaw(file, (int)hmin(remaining, (int64_t)PCM_CACHE_COPY_BLOCK_SIZE));
+				if (written <= 0)
+				{
+					break;
+				}
+				remaining -= written;
+			}
+			file.close();
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not read PCM cache: " + e.getMessage());
+			this->stream.clear();
+			return false;
+		}
+		if (this->stream.size() != size)
+		{
+			this->stream.clear();
+			return false;
+		}
+		this->stream.rewind();
+		if (loudnessAnalyzed != 0 && !this->loudnessAnalyzed)
+		{
+			this->loudness = loudness;
+			this->truePeak = truePeak;
+			this->loudnessAnalyzed = true;
+		}
+		hlog::debug(logTag, "Loaded PCM data from cache: " + this->filename);
+		return true;
+	}
+
+	bool Buffer::_writePcmCache(chstr cacheFilename)
+	{
+		// the content hash allows the entry to stay valid when only the modification time changes
+		uint64_t contentHash = 0;
+		if (!this->_hashSourceData(contentHash))
+		{
+			return false;
+		}
+		unsigned char header[PCM_CACHE_HEADER_SIZE];
+		int version = PCM_CACHE_VERSION;
+		int64_t size = this->stream.size();
+		int loudnessAnalyzed = (this->loudnessAnalyzed ? 1 : 0);
+		memcpy(header, "XPCM", 4);
+		memcpy(&header[4], &version, 4);
+		memcpy(&header[8], &size, 8);
+		memcpy(&header[16], &loudnessAnalyzed, 4);
+		memcpy(&header[20], &this->loudness, 4);
+		memcpy(&header[24], &this->truePeak, 4);
+		memcpy(&header[28], &this->fileSize, 8);
+		memcpy(&header[36], &this->modificationTime, 8);
+		memcpy(&header[44], &contentHash, 8);
+		// the entry is written under a temporary name and renamed so readers never see a partially written file
+		hstr tempFilename = hsprintf("%s.%p.tmp", cacheFilename.cStr(), this);
+		try
+		{
+			hdir::create(hdir::baseDir(cacheFilename));
+			hfile file;
+			file.open(tempFilename, hfaccess::Write);
+			file.writeRaw(header, PCM_CACHE_HEADER_SIZE);
+			file.writeRaw(this->stream);
+			file.close();
+		}
+		catch (hexception& e) // the cache is only an optimization so this is not an error
+		{
+			hlog::warn(logTag, "Could not write PCM cache: " + e.getMessage());
+			hfile::remove(tempFilename);
+			this->stream.rewind();
+			return false;
+		}
+		this->stream.rewind();
+		// not every platform can rename over an existing file, an open reader keeps its own handle to the old entry
+		hfile::remove(cacheFilename);
+		if (!hfile::rename(tempFilename, cacheFilename))
+		{
+			hlog::warn(logTag, "Could not write PCM cache: " + cacheFilename);
+			hfile::remove(tempFilename);
+			return false;
+		}
+		return true;
+	}
+
+	bool Buffer::_needsLoudnessAnalysis() const
+	{
+		return (!this->loudnessAnalyzed && this->category != NULL && (this->category->isLoudnessAnalysisEnabled() || this->category->getLoudnessTarget() < 0.0f));
+	}
+
+	float Buffer::_getNormalizationGain() const
+	{
+		if (this->sharedBuffer != NULL) // players of IMA-ADPCM data use their own buffer, but the shared one was analyzed
+		{
+			return this->sharedBuffer->_getNormalizationGain();
+		}
+		if (!this->loudnessAnalyzed || this->category == NULL || this->category->getLoudnessTarget() >= 0.0f)
+		{
+			return 1.0f;
+		}
+		float result = (float)pow(10.0, (this->category->getLoudnessTarget() - this->loudness) / 20.0);
+		// normalized data shouldn't clip
+		return hmin(result, (float)pow(10.0, -this->truePeak / 20.0));
+	}
+
+	static bool _isNativeFormat(int channels, int samplingRate, int bitsPerSample)
+	{
+		int convertedChannels = channels;
+		int convertedSamplingRate = samplingRate;
+		int convertedBitsPerSample = bitsPerSample;
+		xal::manager->_getConvertedFormat(convertedChannels, convertedSamplingRate, convertedBitsPerSample);
+		return (convertedChannels == channels && convertedSamplingRate == samplingRate && convertedBitsPerSample == bitsPerSample);
+	}
+
+	void Buffer::_optimizePcmData()
+	{
+		if (this->category == NULL || !this->category->isPcmOptimized() || this->source == NULL)
+		{
+			return;
+		}
+		this->_tryLoadMetaData();
+		// the stream already contains data in the format the audio manager converted it to
+		int channels = this->source->getChannels();
+		int samplingRate = this->source->getSamplingRate();
+		int bitsPerSample = this->source->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		int frameSize = channels * bitsPerSample / 8;
+		int originalSize = (int)this->stream.size();
+		int frames = originalSize / frameSize;
+		if (frames == 0)
+		{
+			return;
+		}
+		unsigned char* data = (unsigned char*)this->stream;
+		float threshold = this->category->getSilenceTrimThreshold();
+		if (threshold > 0.0f)
+		{
+			int start = 0;
+			int end = 0;
+			Pcm::findAudibleRange(data, frames, channels, bitsPerSample, threshold, start, end);
+			if (end > start) // completely silent data is kept as it is
+			{
+				if (start > 0)
+				{
+					memmove(data, &data[start * frameSize], (end - start) * frameSize);
+				}
+				frames = end - start;
+			}
+		}
+		if (this->category->isMonoFolding() && channels == 2 && _isNativeFormat(1, samplingRate, bitsPerSample) && Pcm::isDualMono(data, frames, bitsPerSample))
+		{
+			Pcm::foldToMono(data, frames, bitsPerSample);
+			channels = 1;
+		}
+		int storageSamplingRate = this->category->getStorageSamplingRate();
+		if (storageSamplingRate > 0 && storageSamplingRate < samplingRate && _isNativeFormat(channels, storageSamplingRate, bitsPerSample))
+		{
+			frames = Pcm::downsample(data, frames, channels, bitsPerSample, samplingRate, storageSamplingRate);
+			samplingRate = storageSamplingRate;
+		}
+		int size = frames * channels * bitsPerSample / 8;
+		if (size < originalSize)
+		{
+			this->stream.truncate(size);
+			this->stream.setCapacity(hmax(size, 1));
+			this->stream.rewind();
+		}
+		// metadata now describes the stored data which doesn't require any further conversion
+		this->size = size;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = bitsPerSample;
+		this->duration = (float)frames / samplingRate;
+		this->savedSize = originalSize - size;
+		if (this->savedSize > 0)
+		{
+			hlog::writef(logTag, "Optimized PCM data, saved %d bytes: %s", this->savedSize, this->filename.cStr());
+		}
+	}
+
+	void Buffer::_encodeAdpcm()
+	{
+		this->_tryLoadMetaData();
+		// the stream contains data in the format the audio manager converted it to unless it was optimized already
+		int channels = this->source->getChannels();
+		int samplingRate = this->source->getSamplingRate();
+		int bitsPerSample = this->source->getBitsPerSample();
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		if (this->category->isPcmOptimized())
+		{
+			channels = this->channels;
+			samplingRate = this->samplingRate;
+			bitsPerSample = this->bitsPerSample;
+		}
+		int originalSize = (int)this->stream.size();
+		int frames = originalSize / (channels * bitsPerSample / 8);
+		if (frames == 0)
+		{
+			return;
+		}
+		const short* input = (const short*)(unsigned char*)this->stream;
+		harray<short> converted;
+		if (bitsPerSample != 16)
+		{
+			converted.add(0, frames * channels);
+			if (bitsPerSample == 8)
+			{
+				Pcm::convertU8ToS16((unsigned char*)this->stream, &converted[0], frames * channels);
+			}
+			else
+			{
+				Pcm::convertFloatToS16((float*)(unsigned char*)this->stream, &converted[0], frames * channels);
+			}
+			input = &converted[0];
+		}
+		int blockSize = ADPCM_BLOCK_SIZE_PER_CHANNEL * channels;
+		int size = Adpcm::calcEncodedSize(frames, channels, blockSize);
+		harray<unsigned char> encoded;
+		encoded.add(0, size);
+		Adpcm::encode(input, frames, channels, blockSize, &encoded[0]);
+		this->stream.clear(size);
+		this->stream.writeRaw(&encoded[0], size);
+		this->stream.rewind();
+		// metadata describes the data players get after decoding
+		this->size = frames * channels * 2;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = 16;
+		this->duration = (float)frames / samplingRate;
+		this->adpcmBlockSize = blockSize;
+		this->savedSize += originalSize - size;
+		hlog::writef(logTag, "Encoded data as IMA-ADPCM, saved %d bytes: %s", originalSize - size, this->filename.cStr());
+	}
+
 	void Buffer::_update(float timeDelta)
 	{
 		this->idleTime += timeDelta;
@@ -374,20 +1156,26 @@ namespace xal
 	{
 		if (!this->loadedMetaData && this->source != NULL)
 		{
-			bool open = this->source->isOpen();
-			if (!open)
-			{
-				this->source->open();
-			}
+			// a closed source only reads its headers instead of being opened for decoding
+			bool valid = this->source->probe();
 			this->size = this->source->getSize();
 			this->channels = this->source->getChannels();
 			this->samplingRate = this->source->getSamplingRate();
 			this->bitsPerSample = this->source->getBitsPerSample();
 			this->duration = this->source->getDuration();
 			this->loadedMetaData = true;
-			if (!open)
+			if (valid && this->filename != "" && this->sharedBuffer == NULL)
 			{
-				this->source->close();
+				MetaData metaData;
+				metaData.fileSize = this->fileSize;
+				metaData.modificationTime = this->modificationTime;
+				metaData.floatOutput = MetaDataCache::isFloatOutput();
+				metaData.size = this->size;
+				metaData.channels = this->channels;
+				metaData.samplingRate = this->samplingRate;
+				metaData.bitsPerSample = this->bitsPerSample;
+				metaData.duration = this->duration;
+				MetaDataCache::add(this->filename, metaData);
 			}
 		}
 	}
@@ -408,8 +1196,9 @@ namespace xal
 		return false;
 	}
 
-	bool Buffer::_prepareAsyncStream()
+	bool Buffer::_prepareAsyncStream(bool& mapped)
 	{
+		mapped = false;
 		hmutex::ScopeLock lock(&this->asyncLoadMutex);
 		if (!this->asyncLoadQueued || this->asyncLoadDiscarded || this->source == NULL)
 		{
@@ -424,6 +1213,7 @@ namespace xal
 			this->asyncLoadDiscarded = false;
 			return false;
 		}
+		mapped = this->source->isStreamMapped();
 		return true;
 	}
 
@@ -441,9 +1231,7 @@ namespace xal
 			return;
 		}
 		this->_tryLoadMetaData();
-		this->stream.clear(this->source->getSize());
-		this->source->load(this->stream);
-		xal::manager->_convertStream(this->source, this->stream);
+		this->_loadData();
 		this->source->close();
 		this->asyncLoadQueued = false;
 		this->asyncLoadDiscarded = false;
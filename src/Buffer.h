@@ -33,29 +33,38 @@ namespace xal
 	public:
 		friend class AudioManager;
 		friend class BufferAsync;
+		friend class Player;
 
 		Buffer(Sound* sound);
 		Buffer(Category* category, unsigned char* data, int size, int channels, int samplingRate, int bitsPerSample);
+		Buffer(Buffer* sharedBuffer);
+		Buffer(Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		Buffer(Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
 		~Buffer();
 
 		HL_DEFINE_GET(hstr, filename, Filename);
-		HL_DEFINE_GET(int, fileSize, FileSize);
+		HL_DEFINE_GET(int64_t, fileSize, FileSize);
+		HL_DEFINE_GET(int64_t, modificationTime, ModificationTime);
 		inline hstream& getStream() { return this->stream; }
 		HL_DEFINE_GET(Source*, source, Source);
 		HL_DEFINE_GET(float, idleTime, IdleTime);
+		HL_DEFINE_GET(int, adpcmBlockSize, AdpcmBlockSize);
 
-		int getSize();
+		int64_t getSize();
 		int getChannels();
 		int getSamplingRate();
 		int getBitsPerSample();
 		float getDuration();
+		int getSavedSize();
+		float getLoudness();
+		float getTruePeak();
 		Format getFormat() const;
 		bool isLoaded();
+		bool isLoudnessAnalyzed();
 		bool isAsyncLoadQueued();
 		bool isStreamed() const;
 		bool isMemoryManaged() const;
-		// TODO
-		//bool setOffset(int value);
+		bool isAdpcm() const;
 
 		void prepare();
 		bool prepareAsync();
@@ -64,14 +73,20 @@ namespace xal
 		void unbind(Player* player, bool playerPaused);
 		void keepLoaded();
 		void rewind();
+		bool seek(int64_t sample);
 
-		int calcOutputSize(int size);
-		int calcInputSize(int size);
+		int64_t calcOutputSize(int64_t size);
+		int64_t calcInputSize(int64_t size);
 		void readPcmData(hstream& output);
 
+		static Format findFormat(chstr filename);
+		static void findFileInfo(chstr filename, int64_t& fileSize, int64_t& modificationTime);
+
 	protected:
 		hstr filename;
-		int fileSize;
+		int64_t fileSize;
+		int64_t modificationTime;
+		Category* category;
 		BufferMode mode;
 		bool loaded;
 		hstream stream;
@@ -80,19 +95,36 @@ namespace xal
 		hmutex asyncLoadMutex;
 		Source* source;
 		bool loadedMetaData;
-		int size;
+		int64_t size;
 		int channels;
 		int samplingRate;
 		int bitsPerSample;
 		float duration;
+		int savedSize;
+		bool loudnessAnalyzed;
+		float loudness;
+		float truePeak;
 		harray<Player*> boundPlayers;
 		float idleTime;
+		bool adpcm;
+		int adpcmBlockSize;
+		Buffer* sharedBuffer;
 		
+		void _loadData();
+		void _decode(Source* source, hstream& output, bool analyzeLoudness);
+		bool _hashSourceData(uint64_t& hash);
+		hstr _getPcmCacheFilename();
+		bool _readPcmCache(chstr cacheFilename, bool analyzeLoudness);
+		bool _writePcmCache(chstr cacheFilename);
+		bool _needsLoudnessAnalysis() const;
+		float _getNormalizationGain() const;
+		void _optimizePcmData();
+		void _encodeAdpcm();
 		void _update(float timeDelta);
 		void _tryLoadMetaData();
 		bool _tryClearMemory();
 
-		bool _prepareAsyncStream();
+		bool _prepareAsyncStream(bool& mapped);
 		void _decodeFromAsyncStream();
 		void _waitForAsyncLoad(float timeout = 0.0f);
 
@@ -14,6 +14,7 @@
 #include <hltypes/harray.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hmutex.h>
+#include <hltypes/hlog.h>
 #include <hltypes/hplatform.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
@@ -22,15 +23,22 @@
 #include "Buffer.h"
 #include "BufferAsync.h"
 
+#define ASYNC_READER_COUNT 4 // how many files are read at the same time, fast storage handles several requests in parallel
+
 namespace xal
 {
 	harray<Buffer*> BufferAsync::buffers;
 	int BufferAsync::loaded = 0;
+	int BufferAsync::decoding = 0;
+	int64_t BufferAsync::prefetchedSize = 0;
+	hmap<Buffer*, int64_t> BufferAsync::prefetchedSizes;
+	harray<Buffer*> BufferAsync::reading;
 	hmutex BufferAsync::queueMutex;
 
 	hthread BufferAsync::readerThread(&BufferAsync::_read, "XAL async loader");
 	bool BufferAsync::readerRunning = false;
 
+	harray<hthread*> BufferAsync::readerThreads;
 	harray<hthread*> BufferAsync::decoderThreads;
 
 	static int cpus = 0; // needed, because certain calls are made when fetching SystemInfo that are not allowed to be made in secondary threads on some platforms
@@ -50,7 +58,7 @@ namespace xal
 		}
 	}
 
-	bool BufferAsync::queueLoad(Buffer* buffer)
+	int BufferAsync::getCpuCount()
 	{
 		if (cpus == 0)
 		{
@@ -63,9 +71,16 @@ namespace xal
 #else // on Android and other Unix it's better to use CONF since they are more flexible than Apple's hardware and might switch cores on/off dynamically
 			cpus = (int)sysconf(_SC_NPROCESSORS_CONF);
 #endif
+			cpus = hmax(cpus, 1);
 		}
+		return cpus;
+	}
+
+	bool BufferAsync::queueLoad(Buffer* buffer)
+	{
+		BufferAsync::getCpuCount();
 		hmutex::ScopeLock lock(&BufferAsync::queueMutex);
-		if (BufferAsync::buffers.has(buffer))
+		if (BufferAsync::buffers.has(buffer) || BufferAsync::reading.has(buffer))
 		{
 			return false;
 		}
@@ -81,6 +96,10 @@ namespace xal
 	bool BufferAsync::prioritizeLoad(Buffer* buffer)
 	{
 		hmutex::ScopeLock lock(&BufferAsync::queueMutex);
+		if (BufferAsync::reading.has(buffer)) // already being read, it's queued for decoding right after
+		{
+			return true;
+		}
 		if (!BufferAsync::buffers.has(buffer))
 		{
 			return false;
@@ -108,13 +127,69 @@ namespace xal
 		return BufferAsync::readerRunning;
 	}
 
+	int BufferAsync::getPendingCount()
+	{
+		hmutex::ScopeLock lock(&BufferAsync::queueMutex);
+		// buffers that are currently being read or decoded have already been removed from the queue
+		return (BufferAsync::buffers.size() + BufferAsync::reading.size() + BufferAsync::decoding);
+	}
+
+	bool BufferAsync::_canPrefetch(int64_t fileSize)
+	{
+		// compressed data stays in RAM until it's decoded so the readers must not get too far ahead of the decoders,
+		// a file larger than the limit is still read once nothing else is waiting for a decoder
+		int64_t maxPrefetchSize = xal::manager->getMaxAsyncPrefetchSize();
+		return (maxPrefetchSize <= 0 || BufferAsync::prefetchedSize == 0 || BufferAsync::prefetchedSize + fileSize <= maxPrefetchSize);
+	}
+
+	int64_t BufferAsync::_getPrefetchSize(Buffer* buffer)
+	{
+		// mapped files aren't copied to RAM so they don't count towards the limit
+		return ((buffer->getSource() == NULL || buffer->getSource()->getSourceMode() != SourceMode::Mapped) ? buffer->getFileSize() : 0);
+	}
+
+	int64_t BufferAsync::_reserveRead(Buffer* buffer)
+	{
+		int64_t reservedSize = BufferAsync::_getPrefetchSize(buffer);
+		if (!BufferAsync::_canPrefetch(reservedSize))
+		{
+			return -1;
+		}
+		// the size is reserved before reading so other readers respect the limit as well
+		BufferAsync::buffers.removeAt(BufferAsync::loaded);
+		BufferAsync::reading += buffer;
+		BufferAsync::prefetchedSize += reservedSize;
+		return reservedSize;
+	}
+
+	void BufferAsync::_finishRead(Buffer* buffer, int64_t reservedSize, bool streamLoaded, bool mapped)
+	{
+		BufferAsync::reading.remove(buffer);
+		if (streamLoaded)
+		{
+			// an IoProvider that maps its files only reveals that when the file is opened
+			if (mapped)
+			{
+				BufferAsync::prefetchedSize -= reservedSize;
+				reservedSize = 0;
+			}
+			BufferAsync::prefetchedSizes[buffer] = reservedSize;
+			// reads can finish in any order, the buffer is simply decoded after the ones that are already loaded
+			BufferAsync::buffers.insertAt(BufferAsync::loaded, buffer);
+			++BufferAsync::loaded;
+		}
+		else // it was canceled
+		{
+			BufferAsync::prefetchedSize -= reservedSize;
+		}
+	}
+
 	void BufferAsync::_read(hthread* thread)
 	{
-		Buffer* buffer = NULL;
-		bool streamLoaded = true;
-		hthread* decoderThread = NULL;
-		int index = 0;
+		hthread* workerThread = NULL;
+		int unread = 0;
 		int size = 0;
+		bool canRead = false;
 		bool running = true;
 		hmutex::ScopeLock lock;
 		while (running)
@@ -122,34 +197,25 @@ namespace xal
 			running = false;
 			// check for new queued textures
 			lock.acquire(&BufferAsync::queueMutex);
-			if (BufferAsync::buffers.size() > BufferAsync::loaded)
+			unread = BufferAsync::buffers.size() - BufferAsync::loaded;
+			canRead = (unread > 0 && BufferAsync::_canPrefetch(BufferAsync::_getPrefetchSize(BufferAsync::buffers[BufferAsync::loaded])));
+			size = BufferAsync::loaded;
+			if (unread > 0 || BufferAsync::reading.size() > 0)
 			{
 				running = true;
-				buffer = BufferAsync::buffers[BufferAsync::loaded];
-				lock.release();
-				streamLoaded = buffer->_prepareAsyncStream();
-				lock.acquire(&BufferAsync::queueMutex);
-				index = BufferAsync::buffers.indexOf(buffer); // it's possible that the queue was rearranged in the meantime
-				if (streamLoaded)
-				{
-					if (index >= BufferAsync::loaded)
-					{
-						if (index > BufferAsync::loaded) // if texture was moved towards the back of the queue
-						{
-							// put it back to the current decoder position
-							BufferAsync::buffers.removeAt(index);
-							BufferAsync::buffers.insertAt(BufferAsync::loaded, buffer);
-						}
-					}
-					++BufferAsync::loaded;
-				}
-				else // it was canceled
+			}
+			lock.release();
+			// create new reader threads if needed, several files are read at once so the storage isn't limited to one request at a time
+			if (canRead)
+			{
+				unread = hmin(unread, ASYNC_READER_COUNT) - BufferAsync::readerThreads.size();
+				for_iter (i, 0, unread)
 				{
-					BufferAsync::buffers.removeAt(index);
+					workerThread = new hthread(&BufferAsync::_readStreams, "XAL async reader");
+					BufferAsync::readerThreads += workerThread;
+					workerThread->start();
 				}
 			}
-			size = BufferAsync::loaded;
-			lock.release();
 			// create new worker threads if needed
 			if (size > 0)
 			{
@@ -157,25 +223,62 @@ namespace xal
 				size = hmin(size, cpus) - BufferAsync::decoderThreads.size();
 				for_iter (i, 0, size)
 				{
-					decoderThread = new hthread(&BufferAsync::_decode, "XAL async decoder");
-					BufferAsync::decoderThreads += decoderThread;
-					decoderThread->start();
+					workerThread = new hthread(&BufferAsync::_decode, "XAL async decoder");
+					BufferAsync::decoderThreads += workerThread;
+					workerThread->start();
 				}
 			}
 			// check current worker threads' status
+			if (BufferAsync::readerThreads.size() > 0)
+			{
+				running = true;
+				BufferAsync::_joinFinishedThreads(BufferAsync::readerThreads);
+			}
 			if (BufferAsync::decoderThreads.size() > 0)
 			{
 				running = true;
-				for_iter (i, 0, BufferAsync::decoderThreads.size())
-				{
-					if (!BufferAsync::decoderThreads[i]->isRunning())
-					{
-						decoderThread = BufferAsync::decoderThreads.removeAt(i);
-						decoderThread->join();
-						delete decoderThread;
-						--i;
-					}
-				}
+				BufferAsync::_joinFinishedThreads(BufferAsync::decoderThreads);
+			}
+			if (running)
+			{
+				hthread::sleep(1.0f);
+			}
+		}
+	}
+
+	void BufferAsync::_readStreams(hthread* thread)
+	{
+		Buffer* buffer = NULL;
+		int64_t reservedSize = 0;
+		bool streamLoaded = false;
+		bool mapped = false;
+		hmutex::ScopeLock lock(&BufferAsync::queueMutex);
+		while (BufferAsync::buffers.size() > BufferAsync::loaded)
+		{
+			buffer = BufferAsync::buffers[BufferAsync::loaded];
+			reservedSize = BufferAsync::_reserveRead(buffer);
+			if (reservedSize < 0)
+			{
+				break; // the loader starts readers again when the decoders have caught up
+			}
+			lock.release();
+			streamLoaded = buffer->_prepareAsyncStream(mapped);
+			lock.acquire(&BufferAsync::queueMutex);
+			BufferAsync::_finishRead(buffer, reservedSize, streamLoaded, mapped);
+		}
+	}
+
+	void BufferAsync::_joinFinishedThreads(harray<hthread*>& threads)
+	{
+		hthread* thread = NULL;
+		for_iter (i, 0, threads.size())
+		{
+			if (!threads[i]->isRunning())
+			{
+				thread = threads.removeAt(i);
+				thread->join();
+				delete thread;
+				--i;
 			}
 		}
 	}
@@ -183,14 +286,20 @@ namespace xal
 	void BufferAsync::_decode(hthread* thread)
 	{
 		Buffer* buffer = NULL;
+		int64_t reservedSize = 0;
 		hmutex::ScopeLock lock(&BufferAsync::queueMutex);
 		while (BufferAsync::loaded > 0)
 		{
 			buffer = BufferAsync::buffers.removeFirst();
+			reservedSize = BufferAsync::prefetchedSizes[buffer];
+			BufferAsync::prefetchedSizes.removeKey(buffer);
 			--BufferAsync::loaded;
+			++BufferAsync::decoding;
 			lock.release();
 			buffer->_decodeFromAsyncStream();
 			lock.acquire(&BufferAsync::queueMutex);
+			--BufferAsync::decoding;
+			BufferAsync::prefetchedSize -= reservedSize;
 		}
 	}
 
@@ -34,19 +34,32 @@ namespace xal
 		static bool queueLoad(Buffer* buffer);
 		static bool prioritizeLoad(Buffer* buffer);
 		static bool isRunning();
+		static int getPendingCount();
+		static int getCpuCount();
 
 	protected:
 		static harray<Buffer*> buffers;
 		static int loaded;
+		static int decoding;
+		static int64_t prefetchedSize;
+		static hmap<Buffer*, int64_t> prefetchedSizes;
+		static harray<Buffer*> reading;
 		static hmutex queueMutex;
 
 		static hthread readerThread;
 		static bool readerRunning;
 
+		static harray<hthread*> readerThreads;
 		static harray<hthread*> decoderThreads;
 
+		static bool _canPrefetch(int64_t fileSize);
+		static int64_t _getPrefetchSize(Buffer* buffer);
+		static int64_t _reserveRead(Buffer* buffer);
+		static void _finishRead(Buffer* buffer, int64_t reservedSize, bool streamLoaded, bool mapped);
 		static void _read(hthread* thread);
+		static void _readStreams(hthread* thread);
 		static void _decode(hthread* thread);
+		static void _joinFinishedThreads(harray<hthread*>& threads);
 
 	private: // prevents inheritance and instantiation
 		BufferAsync() { }
@@ -19,7 +19,13 @@ namespace xal
 		gain(1.0f),
 		gainFadeTarget(-1.0f),
 		gainFadeSpeed(-1.0f),
-		gainFadeTime(0.0f)
+		gainFadeTime(0.0f),
+		silenceTrimThreshold(0.0f),
+		monoFolding(false),
+		storageSamplingRate(0),
+		loudnessAnalysisEnabled(false),
+		loudnessTarget(0.0f),
+		adpcmStorage(false)
 	{
 		this->name = name;
 		this->bufferMode = bufferMode;
@@ -70,6 +76,11 @@ namespace xal
 		return (this->bufferMode == BufferMode::Managed);
 	}
 
+	bool Category::isPcmOptimized() const
+	{
+		return (this->silenceTrimThreshold > 0.0f || this->monoFolding || this->storageSamplingRate > 0);
+	}
+
 	bool Category::isGainFading()
 	{
 		hmutex::ScopeLock lock(&xal::manager->mutex);
@@ -0,0 +1,233 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <math.h>
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+
+#include "LoudnessMeter.h"
+#include "Pcm.h"
+#include "Utility.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace xal
+{
+	static inline double _energyToLoudness(double energy)
+	{
+		return -0.691 + 10.0 * log10(energy);
+	}
+
+	LoudnessMeter::LoudnessMeter(int channels, int samplingRate) :
+		subBlockFrames(0),
+		subBlockCount(0),
+		subBlockEnergy(0.0),
+		totalEnergy(0.0),
+		totalFrames(0),
+		peak(0.0f)
+	{
+		this->channels = hmax(channels, 1);
+		this->samplingRate = hmax(samplingRate, 1);
+		// K-weighting as defined in ITU-R BS.1770, the coefficients are derived for the actual sampling rate
+		double k = tan(M_PI * 1681.974450955533 / this->samplingRate);
+		double q = 0.7071752369554196;
+		double vh = pow(10.0, 3.999843853973347 / 20.0);
+		double vb = pow(vh, 0.4996667741545416);
+		double a0 = 1.0 + k / q + k * k;
+		this->shelfFilter[0] = (vh + vb * k / q + k * k) / a0;
+		this->shelfFilter[1] = 2.0 * (k * k - vh) / a0;
+		this->shelfFilter[2] = (vh - vb * k / q + k * k) / a0;
+		this->shelfFilter[3] = 2.0 * (k * k - 1.0) / a0;
+		this->shelfFilter[4] = (1.0 - k / q + k * k) / a0;
+		k = tan(M_PI * 38.13547087602444 / this->samplingRate);
+		q = 0.5003270373238773;
+		a0 = 1.0 + k / q + k * k;
+		this->highPassFilter[0] = 1.0;
+		this->highPassFilter[1] = -2.0;
+		this->highPassFilter[2] = 1.0;
+		this->highPassFilter[3] = 2.0 * (k * k - 1.0) / a0;
+		this->highPassFilter[4] = (1.0 - k / q + k * k) / a0;
+		this->filterStates.add(0.0, this->channels * 4);
+		// surround channels of 5.1 data are weighted higher and LFE is ignored
+		for_iter (i, 0, this->channels)
+		{
+			this->channelWeights += (this->channels == 6 && i >= 3 ? (i == 3 ? 0.0 : 1.41) : 1.0);
+		}
+		this->subBlockSize = hmax(hround(this->samplingRate * 0.1f), 1); // gating blocks are 400 ms long and overlap by 75%
+		memset(this->recentEnergies, 0, sizeof(this->recentEnergies));
+		// windowed sinc interpolation filter, split into one set of taps per oversampling phase
+		int count = TRUE_PEAK_OVERSAMPLING * TRUE_PEAK_TAPS;
+		double center = (count - 1) * 0.5;
+		double x = 0.0;
+		double sum = 0.0;
+		for_iter (phase, 0, TRUE_PEAK_OVERSAMPLING)
+		{
+			sum = 0.0;
+			for_iter (i, 0, TRUE_PEAK_TAPS)
+			{
+				int t = phase + i * TRUE_PEAK_OVERSAMPLING;
+				x = (t - center) / TRUE_PEAK_OVERSAMPLING;
+				this->peakCoefficients[phase * TRUE_PEAK_TAPS + i] = (float)((x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x)) * (0.5 - 0.5 * cos(2.0 * M_PI * (t + 0.5) / count)));
+				sum += this->peakCoefficients[phase * TRUE_PEAK_TAPS + i];
+			}
+			for_iter (i, 0, TRUE_PEAK_TAPS)
+			{
+				this->peakCoefficients[phase * TRUE_PEAK_TAPS + i] /= (float)sum;
+			}
+		}
+		this->peakHistory.add(0.0f, this->channels * TRUE_PEAK_TAPS);
+	}
+
+	LoudnessMeter::~LoudnessMeter()
+	{
+	}
+
+	void LoudnessMeter::process(const unsigned char* data, int frames, int bitsPerSample)
+	{
+		if (bitsPerSample == 8)
+		{
+			this->_process(data, frames);
+		}
+		else if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			this->_process((const float*)data, frames);
+		}
+		else
+		{
+			this->_process((const short*)data, frames);
+		}
+	}
+
+	template <typename T>
+	void LoudnessMeter::_process(const T* data, int frames)
+	{
+		double* states = &this->filterStates[0];
+		double* state = NULL;
+		float* history = NULL;
+		const float* coefficients = NULL;
+		float sample = 0.0f;
+		float interpolated = 0.0f;
+		double x = 0.0;
+		double y = 0.0;
+		double energy = 0.0;
+		for_iter (i, 0, frames)
+		{
+			energy = 0.0;
+			for_iter (c, 0, this->channels)
+			{
+				sample = Pcm::toFloat(data[i * this->channels + c]);
+				// true peak
+				history = &this->peakHistory[c * TRUE_PEAK_TAPS];
+				memmove(&history[1], history, (TRUE_PEAK_TAPS - 1) * sizeof(float));
+				history[0] = sample;
+				for_iter (phase, 0, TRUE_PEAK_OVERSAMPLING)
+				{
+					coefficients = &this->peakCoefficients[phase * TRUE_PEAK_TAPS];
+					interpolated = 0.0f;
+					for_iter (j, 0, TRUE_PEAK_TAPS)
+					{
+						interpolated += coefficients[j] * history[j];
+					}
+					this->peak = hmax(this->peak, habs(interpolated));
+				}
+				this->peak = hmax(this->peak, habs(sample));
+				// K-weighting, both stages are biquads in transposed direct form II
+				state = &states[c * 4];
+				x = sample;
+				y = this->shelfFilter[0] * x + state[0];
+				state[0] = this->shelfFilter[1] * x - this->shelfFilter[3] * y + state[1];
+				state[1] = this->shelfFilter[2] * x - this->shelfFilter[4] * y;
+				x = y;
+				y = this->highPassFilter[0] * x + state[2];
+				state[2] = this->highPassFilter[1] * x - this->highPassFilter[3] * y + state[3];
+				state[3] = this->highPassFilter[2] * x - this->highPassFilter[4] * y;
+				energy += this->channelWeights[c] * y * y;
+			}
+			this->subBlockEnergy += energy;
+			++this->subBlockFrames;
+			if (this->subBlockFrames >= this->subBlockSize)
+			{
+				this->_finishSubBlock();
+			}
+		}
+	}
+
+	void LoudnessMeter::_finishSubBlock()
+	{
+		this->recentEnergies[this->subBlockCount % 4] = this->subBlockEnergy;
+		++this->subBlockCount;
+		this->totalEnergy += this->subBlockEnergy;
+		this->totalFrames += this->subBlockFrames;
+		this->subBlockEnergy = 0.0;
+		this->subBlockFrames = 0;
+		if (this->subBlockCount >= 4)
+		{
+			this->blockEnergies += (this->recentEnergies[0] + this->recentEnergies[1] + this->recentEnergies[2] + this->recentEnergies[3]) / (4.0 * this->subBlockSize);
+		}
+	}
+
+	float LoudnessMeter::getIntegratedLoudness() const
+	{
+		if (this->blockEnergies.size() == 0)
+		{
+			// data shorter than one gating block is measured as a whole
+			int64_t frames = this->totalFrames + this->subBlockFrames;
+			double energy = this->totalEnergy + this->subBlockEnergy;
+			if (frames == 0 || energy <= 0.0)
+			{
+				return LOUDNESS_MINIMUM;
+			}
+			return (float)hmax(_energyToLoudness(energy / frames), (double)LOUDNESS_MINIMUM);
+		}
+		// absolute gating
+		double sum = 0.0;
+		int count = 0;
+		for_iter (i, 0, this->blockEnergies.size())
+		{
+			if (_energyToLoudness(this->blockEnergies[i]) > LOUDNESS_MINIMUM)
+			{
+				sum += this->blockEnergies[i];
+				++count;
+			}
+		}
+		if (count == 0)
+		{
+			return LOUDNESS_MINIMUM;
+		}
+		// relative gating
+		double threshold = _energyToLoudness(sum / count) - 10.0;
+		sum = 0.0;
+		count = 0;
+		for_iter (i, 0, this->blockEnergies.size())
+		{
+			if (_energyToLoudness(this->blockEnergies[i]) > LOUDNESS_MINIMUM && _energyToLoudness(this->blockEnergies[i]) > threshold)
+			{
+				sum += this->blockEnergies[i];
+				++count;
+			}
+		}
+		if (count == 0)
+		{
+			return LOUDNESS_MINIMUM;
+		}
+		return (float)_energyToLoudness(sum / count);
+	}
+
+	float LoudnessMeter::getTruePeak() const
+	{
+		if (this->peak <= 0.0f)
+		{
+			return LOUDNESS_MINIMUM;
+		}
+		return (float)(20.0 * log10(this->peak));
+	}
+
+}
@@ -0,0 +1,70 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides an incremental loudness meter following EBU R128.
+
+#ifndef XAL_LOUDNESS_METER_H
+#define XAL_LOUDNESS_METER_H
+
+#include <hltypes/harray.h>
+
+#include "xalExport.h"
+
+#define LOUDNESS_MINIMUM -70.0f // the absolute gate of EBU R128, also used for silence
+#define TRUE_PEAK_OVERSAMPLING 4
+#define TRUE_PEAK_TAPS 12 // per oversampling phase
+
+namespace xal
+{
+	/// @brief Measures integrated loudness and true peak of PCM data that is fed block by block.
+	class LoudnessMeter
+	{
+	public:
+		LoudnessMeter(int channels, int samplingRate);
+		~LoudnessMeter();
+
+		/// @brief Processes interleaved PCM data.
+		/// @param[in] data PCM data.
+		/// @param[in] frames Number of frames.
+		/// @param[in] bitsPerSample Bits per sample.
+		void process(const unsigned char* data, int frames, int bitsPerSample);
+		/// @return Integrated loudness in LUFS.
+		float getIntegratedLoudness() const;
+		/// @return True peak in dBTP.
+		float getTruePeak() const;
+
+	protected:
+		int channels;
+		int samplingRate;
+		double shelfFilter[5];
+		double highPassFilter[5];
+		harray<double> filterStates;
+		harray<double> channelWeights;
+		int subBlockSize;
+		int subBlockFrames;
+		int subBlockCount;
+		double subBlockEnergy;
+		double recentEnergies[4];
+		harray<double> blockEnergies;
+		double totalEnergy;
+		int64_t totalFrames;
+		float peakCoefficients[TRUE_PEAK_OVERSAMPLING * TRUE_PEAK_TAPS];
+		harray<float> peakHistory;
+		float peak;
+
+		template <typename T>
+		void _process(const T* data, int frames);
+		void _finishSubBlock();
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,260 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define __HL_INCLUDE_PLATFORM_HEADERS
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hplatform.h>
+#include <hltypes/hrdir.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "MappedStream.h"
+
+namespace xal
+{
+	// all streams of the same file share one mapping so the compressed data is in memory only once
+	harray<MappedStream::Mapping*> MappedStream::mappings;
+	hmutex MappedStream::mappingsMutex;
+
+	MappedStream::MappedStream() :
+		hsbase(),
+		mapping(NULL),
+		offset(0),
+		streamSize(0),
+		streamPosition(0)
+	{
+	}
+
+	MappedStream::~MappedStream()
+	{
+		this->close();
+	}
+
+	bool MappedStream::open(chstr filename, int64_t offset, int64_t size)
+	{
+		if (!this->_open(MappedStream::_makeFullPath(filename), offset, size))
+		{
+			return false;
+		}
+		this->filename = filename;
+		return true;
+	}
+
+	const unsigned char* MappedStream::getData() const
+	{
+		return (this->mapping != NULL ? &this->mapping->data[this->offset] : NULL);
+	}
+
+	bool MappedStream::_open(chstr fullFilename, int64_t offset, int64_t size)
+	{
+		this->close();
+		this->mapping = MappedStream::_map(fullFilename);
+		if (this->mapping == NULL)
+		{
+			return false;
+		}
+		// a part of the file can be accessed as if it was a file of its own
+		if (size < 0)
+		{
+			size = this->mapping->size - offset;
+		}
+		if (offset < 0 || size < 0 || offset + size > this->mapping->size)
+		{
+			MappedStream::_unmap(this->mapping);
+			this->mapping = NULL;
+			return false;
+		}
+		this->offset = offset;
+		this->streamSize = size;
+		this->streamPosition = 0;
+		this->_updateDataSize();
+		return true;
+	}
+
+	void MappedStream::close()
+	{
+		if (this->mapping != NULL)
+		{
+			MappedStream::_unmap(this->mapping);
+			this->mapping = NULL;
+			this->offset = 0;
+			this->streamSize = 0;
+			this->streamPosition = 0;
+			this->_updateDataSize();
+		}
+	}
+
+	int MappedStream::_read(void* buffer, int count)
+	{
+		if (this->mapping == NULL)
+		{
+			return 0;
+		}
+		int read = (int)hclamp(this->streamSize - this->streamPosition, (int64_t)0, (int64_t)count);
+		if (read > 0)
+		{
+			// the file is never copied as a whole, but decoders still get the requested bytes in their own buffers
+			memcpy(buffer, &this->mapping->data[this->offset + this->streamPosition], read);
+			this->streamPosition += read;
+		}
+		return read;
+	}
+
+	int MappedStream::_write(const void* buffer, int count)
+	{
+		return 0; // mapped files are read-only
+	}
+
+	bool MappedStream::_isOpen() const
+	{
+		return (this->mapping != NULL);
+	}
+
+	int64_t MappedStream::_position() const
+	{
+		return this->streamPosition;
+	}
+
+	bool MappedStream::_seek(int64_t offset, SeekMode seekMode)
+	{
+		if (this->mapping == NULL)
+		{
+			return false;
+		}
+		int64_t target = offset;
+		if (seekMode == hseek::Current)
+		{
+			target += this->streamPosition;
+		}
+		else if (seekMode == hseek::End)
+		{
+			target += this->streamSize;
+		}
+		this->streamPosition = hclamp(target, (int64_t)0, this->streamSize);
+		return true;
+	}
+
+	void MappedStream::_updateDataSize()
+	{
+		this->dataSize = this->streamSize;
+	}
+
+	hstr MappedStream::_makeFullPath(chstr filename)
+	{
+		// resources are located relative to hresource's working directory which doesn't have to be the process' one
+		hstr cwd = hresource::getCwd();
+		if (cwd == "" || cwd == ".")
+		{
+			return filename;
+		}
+		return hrdir::joinPath(cwd, filename);
+	}
+
+	MappedStream::Mapping* MappedStream::_map(chstr filename)
+	{
+		hmutex::ScopeLock lock(&MappedStream::mappingsMutex);
+		foreach (Mapping*, it, MappedStream::mappings)
+		{
+			if ((*it)->filename == filename)
+			{
+				++(*it)->references;
+				return (*it);
+			}
+		}
+		unsigned char* data = NULL;
+		int64_t size = 0;
+		void* handle = NULL;
+#if defined(_WIN32) && !defined(_WINRT)
+		HANDLE file = CreateFileW(filename.wStr().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return NULL;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return NULL;
+		}
+		HANDLE fileMapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file); // the mapping keeps the file open
+		if (fileMapping == NULL)
+		{
+			return NULL;
+		}
+		data = (unsigned char*)MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == NULL)
+		{
+			CloseHandle(fileMapping);
+			return NULL;
+		}
+		size = (int64_t)fileSize.QuadPart;
+		handle = (void*)fileMapping;
+#elif !defined(_WIN32)
+		int file = ::open(filename.cStr(), O_RDONLY);
+		if (file < 0)
+		{
+			return NULL;
+		}
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			::close(file);
+			return NULL;
+		}
+		void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+		::close(file); // the mapping keeps the file open
+		if (mapped == MAP_FAILED)
+		{
+			return NULL;
+		}
+		data = (unsigned char*)mapped;
+		size = (int64_t)info.st_size;
+#else
+		return NULL; // not supported on this platform
+#endif
+		Mapping* mapping = new Mapping();
+		mapping->filename = filename;
+		mapping->data = data;
+		mapping->size = size;
+		mapping->references = 1;
+		mapping->handle = handle;
+		MappedStream::mappings += mapping;
+		return mapping;
+	}
+
+	void MappedStream::_unmap(Mapping* mapping)
+	{
+		hmutex::ScopeLock lock(&MappedStream::mappingsMutex);
+		--mapping->references;
+		if (mapping->references > 0)
+		{
+			return;
+		}
+		MappedStream::mappings -= mapping;
+#if defined(_WIN32) && !defined(_WINRT)
+		UnmapViewOfFile(mapping->data);
+		CloseHandle((HANDLE)mapping->handle);
+#elif !defined(_WIN32)
+		munmap(mapping->data, (size_t)mapping->size);
+#endif
+		delete mapping;
+	}
+
+}
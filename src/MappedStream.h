@@ -0,0 +1,71 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides read-only stream access to a memory-mapped file.
+
+#ifndef XAL_MAPPED_STREAM_H
+#define XAL_MAPPED_STREAM_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	class xalExport MappedStream : public hsbase
+	{
+	public:
+		MappedStream();
+		~MappedStream();
+
+		bool open(chstr filename, int64_t offset = 0, int64_t size = -1);
+		void close();
+		/// @return The data of the opened range in memory or NULL if nothing is open.
+		const unsigned char* getData() const;
+
+	protected:
+		struct Mapping
+		{
+			hstr filename;
+			unsigned char* data;
+			int64_t size;
+			int references;
+			void* handle;
+		};
+
+		Mapping* mapping;
+		int64_t offset;
+		int64_t streamSize;
+		int64_t streamPosition;
+
+		int _read(void* buffer, int count);
+		int _write(const void* buffer, int count);
+		bool _isOpen() const;
+		int64_t _position() const;
+		bool _seek(int64_t offset, SeekMode seekMode = SeekMode::Current);
+		void _updateDataSize();
+
+		bool _open(chstr fullFilename, int64_t offset, int64_t size);
+
+		static harray<Mapping*> mappings;
+		static hmutex mappingsMutex;
+
+		static hstr _makeFullPath(chstr filename);
+		static Mapping* _map(chstr fullFilename);
+		static void _unmap(Mapping* mapping);
+
+	};
+
+}
+
+#endif
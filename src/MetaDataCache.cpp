@@ -0,0 +1,192 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hdir.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "AudioManager.h"
+#include "MetaDataCache.h"
+#include "Utility.h"
+#include "xal.h"
+
+#define META_DATA_CACHE_MAGIC "XMDC"
+#define META_DATA_CACHE_VERSION 1
+#define META_DATA_CACHE_HEADER_SIZE 12 // magic, version, number of entries
+#define META_DATA_CACHE_ENTRY_SIZE 41 // file size, modification time, float output, size, channels, sampling rate, bits per sample, duration
+
+namespace xal
+{
+	hmap<hstr, MetaData> MetaDataCache::entries;
+	hmutex MetaDataCache::entriesMutex;
+
+	bool MetaDataCache::find(chstr filename, int64_t fileSize, int64_t modificationTime, MetaData& metaData)
+	{
+		hmutex::ScopeLock lock(&MetaDataCache::entriesMutex);
+		if (!MetaDataCache::entries.hasKey(filename))
+		{
+			return false;
+		}
+		MetaData& entry = MetaDataCache::entries[filename];
+		if (entry.fileSize != fileSize || entry.modificationTime != modificationTime || entry.floatOutput != MetaDataCache::isFloatOutput())
+		{
+			return false;
+		}
+		metaData = entry;
+		return true;
+	}
+
+	void MetaDataCache::add(chstr filename, const MetaData& metaData)
+	{
+		hmutex::ScopeLock lock(&MetaDataCache::entriesMutex);
+		MetaDataCache::entries[filename] = metaData;
+	}
+
+	bool MetaDataCache::load(chstr filename)
+	{
+		hstream data;
+		try
+		{
+			if (hfile::exists(filename))
+			{
+				hfile file;
+				file.open(filename);
+				data.writeRaw(file);
+			}
+			else if (hresource::exists(filename)) // a cache created offline may be packed together with the audio files
+			{
+				hresource resource;
+				resource.open(filename);
+				data.writeRaw(resource);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not read metadata cache: " + e.getMessage());
+			return false;
+		}
+		data.rewind();
+		unsigned char header[META_DATA_CACHE_HEADER_SIZE];
+		if (data.readRaw(header, META_DATA_CACHE_HEADER_SIZE) != META_DATA_CACHE_HEADER_SIZE || memcmp(header, META_DATA_CACHE_MAGIC, 4) != 0)
+		{
+			hlog::warn(logTag, "Not a metadata cache: " + filename);
+			return false;
+		}
+		int version = 0;
+		int count = 0;
+		memcpy(&version, &header[4], 4);
+		memcpy(&count, &header[8], 4);
+		if (version != META_DATA_CACHE_VERSION || count < 0)
+		{
+			return false; // an outdated cache is simply rebuilt
+		}
+		hmap<hstr, MetaData> loaded;
+		unsigned short length = 0;
+		char name[65536];
+		unsigned char values[META_DATA_CACHE_ENTRY_SIZE];
+		MetaData metaData;
+		for_iter (i, 0, count)
+		{
+			if (data.readRaw(&length, 2) != 2 || data.readRaw(name, length) != length || data.readRaw(values, META_DATA_CACHE_ENTRY_SIZE) != META_DATA_CACHE_ENTRY_SIZE)
+			{
+				hlog::warn(logTag, "Metadata cache is incomplete: " + filename);
+				return false;
+			}
+			memcpy(&metaData.fileSize, &values[0], 8);
+			memcpy(&metaData.modificationTime, &values[8], 8);
+			metaData.floatOutput = (values[16] != 0);
+			memcpy(&metaData.size, &values[17], 8);
+			memcpy(&metaData.channels, &values[25], 4);
+			memcpy(&metaData.samplingRate, &values[29], 4);
+			memcpy(&metaData.bitsPerSample, &values[33], 4);
+			memcpy(&metaData.duration, &values[37], 4);
+			loaded[hstr(name, (int)length)] = metaData;
+		}
+		hmutex::ScopeLock lock(&MetaDataCache::entriesMutex);
+		foreach_m (MetaData, it, loaded)
+		{
+			MetaDataCache::entries[it->first] = it->second;
+		}
+		return true;
+	}
+
+	bool MetaDataCache::save(chstr filename)
+	{
+		hstream data;
+		hmutex::ScopeLock lock(&MetaDataCache::entriesMutex);
+		unsigned char header[META_DATA_CACHE_HEADER_SIZE];
+		int version = META_DATA_CACHE_VERSION;
+		int count = MetaDataCache::entries.size();
+		memcpy(header, META_DATA_CACHE_MAGIC, 4);
+		memcpy(&header[4], &version, 4);
+		memcpy(&header[8], &count, 4);
+		data.writeRaw(header, META_DATA_CACHE_HEADER_SIZE);
+		unsigned short length = 0;
+		unsigned char values[META_DATA_CACHE_ENTRY_SIZE];
+		foreach_m (MetaData, it, MetaDataCache::entries)
+		{
+			length = (unsigned short)it->first.size();
+			data.writeRaw((unsigned char*)&length, 2);
+			data.writeRaw((unsigned char*)it->first.cStr(), length);
+			memcpy(&values[0], &it->second.fileSize, 8);
+			memcpy(&values[8], &it->second.modificationTime, 8);
+			values[16] = (it->second.floatOutput ? 1 : 0);
+			memcpy(&values[17], &it->second.size, 8);
+			memcpy(&values[25], &it->second.channels, 4);
+			memcpy(&values[29], &it->second.samplingRate, 4);
+			memcpy(&values[33], &it->second.bitsPerSample, 4);
+			memcpy(&values[37], &it->second.duration, 4);
+			data.writeRaw(values, META_DATA_CACHE_ENTRY_SIZE);
+		}
+		lock.release();
+		data.rewind();
+		try
+		{
+			hdir::create(hdir::baseDir(filename));
+			hfile file;
+			file.open(filename, hfaccess::Write);
+			file.writeRaw(data);
+			file.close();
+		}
+		catch (hexception& e)
+		{
+			hlog::warn(logTag, "Could not write metadata cache: " + e.getMessage());
+			return false;
+		}
+		return true;
+	}
+
+	void MetaDataCache::clear()
+	{
+		hmutex::ScopeLock lock(&MetaDataCache::entriesMutex);
+		MetaDataCache::entries.clear();
+	}
+
+	bool MetaDataCache::isFloatOutput()
+	{
+		int channels = 2;
+		int samplingRate = 44100;
+		int bitsPerSample = FLOAT_BITS_PER_SAMPLE;
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+		return (bitsPerSample == FLOAT_BITS_PER_SAMPLE);
+	}
+	
+}
@@ -0,0 +1,71 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides a persistent cache for the metadata of audio files.
+
+#ifndef XAL_META_DATA_CACHE_H
+#define XAL_META_DATA_CACHE_H
+
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	struct MetaData
+	{
+		int64_t fileSize;
+		int64_t modificationTime;
+		bool floatOutput;
+		int64_t size;
+		int channels;
+		int samplingRate;
+		int bitsPerSample;
+		float duration;
+	};
+
+	/// @note Entries are only valid as long as the file's size and modification time don't change.
+	class MetaDataCache
+	{
+	public:
+		/// @brief Finds the cached metadata of a file.
+		/// @param[in] filename Filename of the audio file.
+		/// @param[in] fileSize Current size of the file.
+		/// @param[in] modificationTime Current modification time of the file.
+		/// @param[out] metaData The cached metadata.
+		/// @return True if valid metadata was found.
+		static bool find(chstr filename, int64_t fileSize, int64_t modificationTime, MetaData& metaData);
+		/// @brief Adds or replaces the metadata of a file.
+		static void add(chstr filename, const MetaData& metaData);
+		/// @brief Loads a cache file and adds its entries.
+		static bool load(chstr filename);
+		/// @brief Saves all entries to a cache file.
+		static bool save(chstr filename);
+		/// @brief Removes all entries.
+		static void clear();
+		/// @return True if sources currently provide float data.
+		/// @note Sources provide different data depending on the audio system so metadata probed with another one isn't valid.
+		static bool isFloatOutput();
+
+	protected:
+		static hmap<hstr, MetaData> entries;
+		static hmutex entriesMutex;
+
+	private: // prevents inheritance and instantiation
+		MetaDataCache() { }
+		~MetaDataCache() { }
+
+	};
+	
+}
+
+#endif
@@ -0,0 +1,179 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "Pcm.h"
+#include "Resampler.h"
+#include "Utility.h"
+
+namespace xal
+{
+	template <typename T>
+	static void _findAudibleRange(const T* data, int frames, int channels, float threshold, int& start, int& end)
+	{
+		int count = frames * channels;
+		int first = 0;
+		while (first < count && habs(Pcm::toFloat(data[first])) <= threshold)
+		{
+			++first;
+		}
+		int last = count - 1;
+		while (last > first && habs(Pcm::toFloat(data[last])) <= threshold)
+		{
+			--last;
+		}
+		start = first / channels;
+		end = (first < count ? last / channels + 1 : start);
+	}
+
+	template <typename T>
+	static bool _isDualMono(const T* data, int frames)
+	{
+		for_iter (i, 0, frames)
+		{
+			if (data[i * 2] != data[i * 2 + 1])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename T>
+	static void _foldToMono(T* data, int frames)
+	{
+		// output index is never ahead of the input index so this works in place
+		for_iter (i, 0, frames)
+		{
+			data[i] = data[i * 2];
+		}
+	}
+
+	void Pcm::convertU8ToS16(const unsigned char* input, short* output, int count)
+	{
+		for_iter (i, 0, count)
+		{
+			output[i] = (short)(((int)input[i] - 128) << 8);
+		}
+	}
+
+	void Pcm::convertS24ToS16(const unsigned char* input, short* output, int count)
+	{
+		// the lowest byte is simply dropped
+		for_iter (i, 0, count)
+		{
+			output[i] = (short)(input[i * 3 + 1] | (input[i * 3 + 2] << 8));
+		}
+	}
+
+	void Pcm::convertS24ToFloat(const unsigned char* input, float* output, int count)
+	{
+		static const float factor = 1.0f / 8388608.0f;
+		unsigned int value = 0;
+		for_iter (i, 0, count)
+		{
+			// assembled unsigned and then sign-extended, shifting into the sign bit of a signed value is undefined
+			value = input[i * 3] | (input[i * 3 + 1] << 8) | ((unsigned int)input[i * 3 + 2] << 16);
+			output[i] = ((int)(value << 8) >> 8) * factor;
+		}
+	}
+
+	void Pcm::convertS32ToS16(const int* input, short* output, int count)
+	{
+		for_iter (i, 0, count)
+		{
+			output[i] = (short)(input[i] >> 16);
+		}
+	}
+
+	void Pcm::convertS32ToFloat(const int* input, float* output, int count)
+	{
+		static const float factor = 1.0f / 2147483648.0f;
+		for_iter (i, 0, count)
+		{
+			output[i] = input[i] * factor;
+		}
+	}
+
+	void Pcm::convertFloatToS16(const float* input, short* output, int count)
+	{
+		// clamping first, converting out-of-range values to int is undefined (NaN fails every comparison so it's caught separately)
+		for_iter (i, 0, count)
+		{
+			output[i] = (input[i] == input[i] ? (short)(hclamp(input[i], -1.0f, 1.0f) * 32767.0f) : 0);
+		}
+	}
+
+	void Pcm::findAudibleRange(const unsigned char* data, int frames, int channels, int bitsPerSample, float threshold, int& start, int& end)
+	{
+		if (bitsPerSample == 8)
+		{
+			_findAudibleRange(data, frames, channels, threshold, start, end);
+		}
+		else if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			_findAudibleRange((const float*)data, frames, channels, threshold, start, end);
+		}
+		else
+		{
+			_findAudibleRange((const short*)data, frames, channels, threshold, start, end);
+		}
+	}
+
+	bool Pcm::isDualMono(const unsigned char* data, int frames, int bitsPerSample)
+	{
+		if (bitsPerSample == 8)
+		{
+			return _isDualMono(data, frames);
+		}
+		if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			return _isDualMono((const float*)data, frames);
+		}
+		return _isDualMono((const short*)data, frames);
+	}
+
+	void Pcm::foldToMono(unsigned char* data, int frames, int bitsPerSample)
+	{
+		if (bitsPerSample == 8)
+		{
+			_foldToMono(data, frames);
+		}
+		else if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			_foldToMono((float*)data, frames);
+		}
+		else
+		{
+			_foldToMono((short*)data, frames);
+		}
+	}
+
+	int Pcm::downsample(unsigned char* data, int frames, int channels, int bitsPerSample, int samplingRate, int newSamplingRate)
+	{
+		if (newSamplingRate <= 0 || newSamplingRate >= samplingRate)
+		{
+			return frames;
+		}
+		// the kernel reaches back further than the output position so it can't work in place
+		Resampler resampler(channels, samplingRate, newSamplingRate);
+		hstream output;
+		resampler.process(data, frames, bitsPerSample, output, bitsPerSample);
+		resampler.flush(output, bitsPerSample);
+		if (output.size() > 0)
+		{
+			memcpy(data, &output[0], (size_t)output.size());
+		}
+		return (int)(output.size() / (channels * bitsPerSample / 8));
+	}
+
+}
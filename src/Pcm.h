@@ -0,0 +1,72 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines utilities for PCM sample format conversion.
+
+#ifndef XAL_PCM_H
+#define XAL_PCM_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	/// @note The conversion loops are kept free of branches and aliasing so compilers can vectorize them.
+	class Pcm
+	{
+	public:
+		/// @return Sample as float in the range of -1.0-1.0.
+		static inline float toFloat(unsigned char value) { return ((int)value - 128) / 128.0f; } // 8 bit PCM data is unsigned
+		/// @return Sample as float in the range of -1.0-1.0.
+		static inline float toFloat(short value) { return value / 32768.0f; }
+		/// @return Sample as float in the range of -1.0-1.0.
+		static inline float toFloat(float value) { return value; }
+		/// @brief Converts a float sample in the range of -1.0-1.0 and clamps it.
+		static inline void fromFloat(float value, unsigned char& output) { output = (unsigned char)hclamp(hround(value * 128.0f) + 128, 0, 255); }
+		/// @brief Converts a float sample in the range of -1.0-1.0 and clamps it.
+		static inline void fromFloat(float value, short& output) { output = (short)hclamp(hround(value * 32768.0f), -32768, 32767); }
+		/// @brief Converts a float sample in the range of -1.0-1.0 and clamps it.
+		static inline void fromFloat(float value, float& output) { output = value; }
+
+		static void convertU8ToS16(const unsigned char* input, short* output, int count);
+		static void convertS24ToS16(const unsigned char* input, short* output, int count);
+		static void convertS24ToFloat(const unsigned char* input, float* output, int count);
+		static void convertS32ToS16(const int* input, short* output, int count);
+		static void convertS32ToFloat(const int* input, float* output, int count);
+		static void convertFloatToS16(const float* input, short* output, int count);
+
+		/// @brief Finds the range of frames that contain samples above a threshold.
+		/// @param[in] data Interleaved PCM data.
+		/// @param[in] frames Number of frames.
+		/// @param[in] channels Number of channels.
+		/// @param[in] bitsPerSample Bits per sample.
+		/// @param[in] threshold Amplitude threshold in the range of 0.0-1.0.
+		/// @param[out] start First frame above the threshold.
+		/// @param[out] end Frame after the last frame above the threshold.
+		static void findAudibleRange(const unsigned char* data, int frames, int channels, int bitsPerSample, float threshold, int& start, int& end);
+		/// @return True if both channels of stereo data are identical.
+		static bool isDualMono(const unsigned char* data, int frames, int bitsPerSample);
+		/// @brief Folds stereo data with identical channels into mono data in place.
+		static void foldToMono(unsigned char* data, int frames, int bitsPerSample);
+		/// @brief Downsamples data in place.
+		/// @return Number of frames after resampling.
+		/// @note Frequencies above the new Nyquist frequency are filtered out beforehand so they don't alias.
+		static int downsample(unsigned char* data, int frames, int channels, int bitsPerSample, int samplingRate, int newSamplingRate);
+
+	private: // prevents inheritance and instantiation
+		Pcm() { }
+		~Pcm() { }
+
+	};
+	
+}
+
+#endif
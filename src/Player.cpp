@@ -13,6 +13,8 @@
 #include "Source.h"
 #include "Buffer.h"
 #include "Category.h"
+#include "Generator_Source.h"
+#include "Memory_Source.h"
 #include "Player.h"
 #include "Sound.h"
 #include "Utility.h"
@@ -28,17 +30,34 @@ namespace xal
 		fadeSpeed(0.0f),
 		fadeTime(0.0f),
 		offset(0.0f),
+		seekSample(-1),
 		bufferIndex(0),
 		processedByteCount(0),
 		idleTime(0.0f),
 		asyncPlayQueued(false)
 	{
 		this->sound = sound;
-		this->buffer = sound->buffer;
-		if (this->buffer->isStreamed()) // streamed buffers cannot be shared
+		this->buffer = sound->_bindPlayer();
+		if (this->buffer->getFormat() == Format::Generated) // each player runs the callback separately
+		{
+			Generator_Source* source = (Generator_Source*)this->buffer->getSource();
+			this->buffer = xal::manager->_createBuffer(this->sound->getCategory(), source->getCallback(), source->getUserData(),
+				source->getChannels(), source->getSamplingRate(), source->getBitsPerSample());
+		}
+		else if (this->buffer->getFormat() == Format::Memory && this->buffer->isStreamed()) // each player reads the application's data separately
+		{
+			Memory_Source* source = (Memory_Source*)this->buffer->getSource();
+			this->buffer = xal::manager->_createBuffer(this->sound->getCategory(), source->getData(), source->getDataSize(),
+				source->getChannels(), source->getSamplingRate(), source->getBitsPerSample(), NULL, NULL);
+		}
+		else if (this->buffer->isStreamed()) // streamed buffers cannot be shared
 		{
 			this->buffer = xal::manager->_createBuffer(this->sound);
 		}
+		else if (this->buffer->isAdpcm()) // compressed data is shared, but each player decodes it separately
+		{
+			this->buffer = xal::manager->_createBuffer(this->buffer);
+		}
 	}
 
 	Player::~Player()
@@ -49,6 +68,7 @@ namespace xal
 		{
 			xal::manager->_destroyBuffer(this->buffer);
 		}
+		this->sound->_unbindPlayer();
 	}
 
 	float Player::getGain()
@@ -102,10 +122,10 @@ namespace xal
 		return ((float)this->getSamplePosition() / this->buffer->getSamplingRate());
 	}
 
-	unsigned int Player::getSamplePosition()
+	int64_t Player::getSamplePosition()
 	{
 		hmutex::ScopeLock lock(&xal::manager->mutex);
-		unsigned int position = this->_systemGetBufferPosition();
+		int64_t position = this->_systemGetBufferPosition();
 		if (this->sound->isStreamed() && this->_systemNeedsStreamedBufferPositionCorrection())
 		{
 			// corrects position by using number of processed bytes (circular)
@@ -113,8 +133,12 @@ namespace xal
 			// adds streamed processed byte count
 			position += this->processedByteCount;
 		}
-		position = hmin(position, (unsigned int)this->sound->getSize());
-		return (unsigned int)(position / (this->buffer->getChannels() * this->buffer->getBitsPerSample() * 0.125f));
+		int64_t soundSize = this->sound->getSize();
+		if (soundSize > 0) // generated audio data has no known length
+		{
+			position = hmin(position, soundSize);
+		}
+		return (position * 8 / (this->buffer->getChannels() * this->buffer->getBitsPerSample()));
 	}
 
 	hstr Player::getName() const
@@ -132,7 +156,7 @@ namespace xal
 		return this->buffer->getDuration();
 	}
 	
-	int Player::getSize()
+	int64_t Player::getSize()
 	{
 		return this->buffer->getSize();
 	}
@@ -143,7 +167,7 @@ namespace xal
 		{
 			return (int)this->buffer->getStream().size();
 		}
-		return this->buffer->getSize();
+		return (int)this->buffer->getSize();
 	}
 
 	float Player::getBufferIdleTime()
@@ -151,7 +175,7 @@ namespace xal
 		return this->buffer->getIdleTime();
 	}
 	
-	int Player::getSourceSize()
+	int64_t Player::getSourceSize()
 	{
 		return this->buffer->getSource()->getRamSize();
 	}
@@ -249,7 +273,7 @@ namespace xal
 			else if (!this->_isAsyncPlayQueued()) // would cause the sound to stop
 			{
 				this->processedByteCount += this->_systemUpdateStream();
-				int soundSize = this->sound->getSize();
+				int64_t soundSize = this->sound->getSize();
 				if (soundSize > 0 && this->looping && this->processedByteCount >= soundSize)
 				{
 					this->processedByteCount %= soundSize;
@@ -310,6 +334,17 @@ namespace xal
 		hmutex::ScopeLock lock(&xal::manager->mutex);
 		this->_pause(fadeTime);
 	}
+
+	void Player::seek(float time)
+	{
+		this->seekSamples(hmax((int64_t)((double)time * this->buffer->getSamplingRate() + 0.5), (int64_t)0));
+	}
+
+	void Player::seekSamples(int64_t sample)
+	{
+		hmutex::ScopeLock lock(&xal::manager->mutex);
+		this->_seekSamples(sample);
+	}
 	
 	void Player::_play(float fadeTime, bool looping)
 	{
@@ -341,7 +376,13 @@ namespace xal
 		if (!alreadyFading && !this->_systemIsPlaying())
 		{
 			this->buffer->prepare();
+			if (this->seekSample >= 0 && this->sound->isStreamed())
+			{
+				this->buffer->seek(this->seekSample);
+				this->processedByteCount = this->seekSample * this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8;
+			}
 			this->_systemPrepareBuffer();
+			this->seekSample = -1;
 			if (this->paused)
 			{
 				this->_systemSetOffset(this->offset);
@@ -404,6 +445,7 @@ namespace xal
 		this->paused = false;
 		this->_stopSound(fadeTime);
 		this->offset = 0.0f;
+		this->seekSample = -1;
 		this->processedByteCount = 0;
 	}
 
@@ -418,9 +460,38 @@ namespace xal
 		this->_stopSound(fadeTime);
 	}
 
+	void Player::_seekSamples(int64_t sample)
+	{
+		int64_t frames = this->buffer->getSize() / (this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8);
+		bool playing = (this->_systemIsPlaying() && !this->_isFadingOut());
+		bool looping = this->looping;
+		float fadeSpeed = this->fadeSpeed;
+		float fadeTime = this->fadeTime;
+		if (this->_systemIsPlaying() || this->paused)
+		{
+			// stopping discards everything the audio-system has queued already
+			this->_stop();
+		}
+		this->seekSample = hmax(sample, (int64_t)0);
+		if (frames > 0) // generated audio data has no known length
+		{
+			this->seekSample = hmin(this->seekSample, frames - 1);
+		}
+		if (playing)
+		{
+			this->_play(0.0f, looping);
+			if (fadeSpeed > 0.0f) // a fade-in continues where it was
+			{
+				this->fadeSpeed = fadeSpeed;
+				this->fadeTime = fadeTime;
+				this->_systemUpdateGain();
+			}
+		}
+	}
+
 	float Player::_calcGain() const
 	{
-		float result = this->gain * this->sound->getCategory()->_getGain() * xal::manager->_getGlobalGain();
+		float result = this->gain * this->sound->getCategory()->_getGain() * xal::manager->_getGlobalGain() * this->buffer->_getNormalizationGain();
 		if (this->_isFading())
 		{
 			result *= this->fadeTime;
@@ -440,7 +511,7 @@ namespace xal
 		}
 		this->offset = this->_systemGetOffset();
 		this->processedByteCount += this->_systemStop();
-		int soundSize = this->sound->getSize();
+		int64_t soundSize = this->sound->getSize();
 		if (soundSize > 0 && this->sound->isStreamed() && this->looping && this->processedByteCount >= soundSize)
 		{
 			this->processedByteCount %= soundSize;
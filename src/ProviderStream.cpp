@@ -0,0 +1,195 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hresource.h>
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "AudioManager.h"
+#include "IoProvider.h"
+#include "ProviderStream.h"
+#include "xal.h"
+
+namespace xal
+{
+	ProviderStream::ProviderStream(IoProvider* provider) :
+		hsbase(),
+		provider(provider),
+		handle(NULL),
+		data(NULL),
+		offset(0),
+		streamSize(0),
+		streamPosition(0)
+	{
+	}
+
+	ProviderStream::~ProviderStream()
+	{
+		this->close();
+	}
+
+	bool ProviderStream::isMapped() const
+	{
+		return (this->data != NULL);
+	}
+
+	const unsigned char* ProviderStream::getData() const
+	{
+		return this->data;
+	}
+
+	bool ProviderStream::open(chstr filename, int64_t offset, int64_t size)
+	{
+		this->close();
+		this->handle = this->provider->open(filename);
+		if (this->handle == NULL)
+		{
+			return false;
+		}
+		// a part of the file can be accessed as if it was a file of its own
+		int64_t fileSize = this->provider->size(this->handle);
+		if (size < 0)
+		{
+			size = fileSize - offset;
+		}
+		if (offset < 0 || size < 0 || offset + size > fileSize)
+		{
+			this->close();
+			return false;
+		}
+		this->offset = offset;
+		this->streamSize = size;
+		this->streamPosition = 0;
+		// providers that keep their data in memory anyway don't need any reads at all
+		this->data = this->provider->mapRange(this->handle, offset, size);
+		if (this->data == NULL && !this->provider->seek(this->handle, offset))
+		{
+			this->close();
+			return false;
+		}
+		this->_updateDataSize();
+		return true;
+	}
+
+	void ProviderStream::close()
+	{
+		if (this->handle != NULL)
+		{
+			this->provider->close(this->handle);
+			this->handle = NULL;
+			this->data = NULL;
+			this->offset = 0;
+			this->streamSize = 0;
+			this->streamPosition = 0;
+			this->_updateDataSize();
+		}
+	}
+
+	int ProviderStream::_read(void* buffer, int count)
+	{
+		if (this->handle == NULL)
+		{
+			return 0;
+		}
+		int read = (int)hclamp(this->streamSize - this->streamPosition, (int64_t)0, (int64_t)count);
+		if (read > 0)
+		{
+			if (this->data != NULL)
+			{
+				// saves the provider call, the hsbase interface still requires the data in the caller's buffer
+				memcpy(buffer, &this->data[this->streamPosition], read);
+			}
+			else
+			{
+				read = hmax(this->provider->read(this->handle, (unsigned char*)buffer, read), 0);
+			}
+			this->streamPosition += read;
+		}
+		return read;
+	}
+
+	int ProviderStream::_write(const void* buffer, int count)
+	{
+		return 0; // provider files are read-only
+	}
+
+	bool ProviderStream::_isOpen() const
+	{
+		return (this->handle != NULL);
+	}
+
+	int64_t ProviderStream::_position() const
+	{
+		return this->streamPosition;
+	}
+
+	bool ProviderStream::_seek(int64_t offset, SeekMode seekMode)
+	{
+		if (this->handle == NULL)
+		{
+			return false;
+		}
+		int64_t target = offset;
+		if (seekMode == hseek::Current)
+		{
+			target += this->streamPosition;
+		}
+		else if (seekMode == hseek::End)
+		{
+			target += this->streamSize;
+		}
+		target = hclamp(target, (int64_t)0, this->streamSize);
+		if (this->data == NULL && !this->provider->seek(this->handle, this->offset + target))
+		{
+			return false;
+		}
+		this->streamPosition = target;
+		return true;
+	}
+
+	void ProviderStream::_updateDataSize()
+	{
+		this->dataSize = this->streamSize;
+	}
+
+	bool ProviderStream::exists(chstr filename)
+	{
+		IoProvider* provider = xal::manager->getIoProvider();
+		if (provider != NULL)
+		{
+			return provider->exists(filename);
+		}
+		return hresource::exists(filename);
+	}
+
+	hsbase* ProviderStream::create(chstr filename)
+	{
+		IoProvider* provider = xal::manager->getIoProvider();
+		if (provider == NULL)
+		{
+			if (!hresource::exists(filename))
+			{
+				return NULL;
+			}
+			hresource* resource = new hresource();
+			resource->open(filename);
+			return resource;
+		}
+		ProviderStream* stream = new ProviderStream(provider);
+		if (!stream->open(filename))
+		{
+			delete stream;
+			return NULL;
+		}
+		return stream;
+	}
+
+}
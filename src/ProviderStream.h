@@ -0,0 +1,64 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides read-only stream access to a file of an IoProvider.
+
+#ifndef XAL_PROVIDER_STREAM_H
+#define XAL_PROVIDER_STREAM_H
+
+#include <hltypes/hsbase.h>
+#include <hltypes/hstring.h>
+
+#include "xalExport.h"
+
+namespace xal
+{
+	class IoProvider;
+
+	class xalExport ProviderStream : public hsbase
+	{
+	public:
+		ProviderStream(IoProvider* provider);
+		~ProviderStream();
+
+		bool isMapped() const;
+		/// @return The mapped data of the opened range or NULL if the IoProvider doesn't map it.
+		const unsigned char* getData() const;
+
+		bool open(chstr filename, int64_t offset = 0, int64_t size = -1);
+		void close();
+
+		/// @brief Checks whether a file exists in the current IoProvider or as resource.
+		/// @return True if the file exists.
+		static bool exists(chstr filename);
+		/// @brief Opens a file from the current IoProvider or as resource.
+		/// @return The opened stream or NULL if the file could not be opened.
+		static hsbase* create(chstr filename);
+
+	protected:
+		IoProvider* provider;
+		void* handle;
+		const unsigned char* data;
+		int64_t offset;
+		int64_t streamSize;
+		int64_t streamPosition;
+
+		int _read(void* buffer, int count);
+		int _write(const void* buffer, int count);
+		bool _isOpen() const;
+		int64_t _position() const;
+		bool _seek(int64_t offset, SeekMode seekMode = SeekMode::Current);
+		void _updateDataSize();
+
+	};
+
+}
+
+#endif
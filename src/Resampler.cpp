@@ -0,0 +1,204 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <math.h>
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "Pcm.h"
+#include "Resampler.h"
+#include "Utility.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace xal
+{
+	Resampler::Resampler(int channels, int samplingRate, int newSamplingRate) :
+		history(NULL),
+		historyCapacity(0),
+		historyStart(0),
+		inputFrames(0),
+		outputFrames(0)
+	{
+		this->channels = hmax(channels, 1);
+		this->samplingRate = hmax(samplingRate, 1);
+		this->newSamplingRate = hmax(newSamplingRate, 1);
+		// the kernel is stretched over the lower sampling rate so downsampling filters out what would alias and upsampling filters out images
+		this->step = hmax((double)this->samplingRate / this->newSamplingRate, 1.0);
+		this->radius = RESAMPLER_ZERO_CROSSINGS * this->step; // in input frames
+		// Blackman-windowed sinc
+		this->tableSize = RESAMPLER_ZERO_CROSSINGS * RESAMPLER_TABLE_RESOLUTION;
+		this->kernel = new float[this->tableSize + 2];
+		double x = 0.0;
+		for_iter (i, 0, this->tableSize + 2)
+		{
+			x = (double)i / RESAMPLER_TABLE_RESOLUTION;
+			this->kernel[i] = (x >= RESAMPLER_ZERO_CROSSINGS ? 0.0f : (float)((i == 0 ? 1.0 : sin(M_PI * RESAMPLER_CUTOFF * x) / (M_PI * RESAMPLER_CUTOFF * x)) *
+				(0.42 + 0.5 * cos(M_PI * x / RESAMPLER_ZERO_CROSSINGS) + 0.08 * cos(2.0 * M_PI * x / RESAMPLER_ZERO_CROSSINGS))));
+		}
+		this->weights = new float[(int)(this->radius * 2.0) + 2];
+	}
+
+	Resampler::~Resampler()
+	{
+		delete[] this->kernel;
+		delete[] this->weights;
+		if (this->history != NULL)
+		{
+			delete[] this->history;
+		}
+	}
+
+	bool Resampler::isSupported(int bitsPerSample)
+	{
+		return (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == FLOAT_BITS_PER_SAMPLE);
+	}
+
+	int Resampler::process(const unsigned char* data, int frames, int bitsPerSample, hstream& output, int outputBitsPerSample)
+	{
+		if (frames > 0)
+		{
+			if (bitsPerSample == 8)
+			{
+				this->_append(data, frames);
+			}
+			else if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+			{
+				this->_append((const float*)data, frames);
+			}
+			else
+			{
+				this->_append((const short*)data, frames);
+			}
+		}
+		return this->_write(output, outputBitsPerSample, false);
+	}
+
+	int Resampler::flush(hstream& output, int outputBitsPerSample)
+	{
+		return this->_write(output, outputBitsPerSample, true);
+	}
+
+	template <typename T>
+	void Resampler::_append(const T* data, int frames)
+	{
+		int kept = (int)(this->inputFrames - this->historyStart) * this->channels;
+		int count = frames * this->channels;
+		if (kept + count > this->historyCapacity)
+		{
+			this->historyCapacity = (kept + count) * 2;
+			float* history = new float[this->historyCapacity];
+			if (this->history != NULL)
+			{
+				memcpy(history, this->history, kept * sizeof(float));
+				delete[] this->history;
+			}
+			this->history = history;
+		}
+		float* input = &this->history[kept];
+		for_iter (i, 0, count)
+		{
+			input[i] = Pcm::toFloat(data[i]);
+		}
+		this->inputFrames += frames;
+	}
+
+	template <typename T>
+	void Resampler::_resample(T* output, int frames)
+	{
+		double center = 0.0;
+		double position = 0.0;
+		int64_t first = 0;
+		int64_t last = 0;
+		int count = 0;
+		int index = 0;
+		float weightSum = 0.0f;
+		float sum = 0.0f;
+		const float* input = NULL;
+		for_iter (i, 0, frames)
+		{
+			center = (double)((this->outputFrames + i) * this->samplingRate) / this->newSamplingRate;
+			first = hmax((int64_t)ceil(center - this->radius), (int64_t)0);
+			last = hmin((int64_t)floor(center + this->radius), this->inputFrames - 1);
+			count = (int)(last - first + 1);
+			weightSum = 0.0f;
+			for_iter (j, 0, count)
+			{
+				position = fabs(first + j - center) / this->step * RESAMPLER_TABLE_RESOLUTION;
+				index = (int)position;
+				this->weights[j] = (index < this->tableSize ? (float)(this->kernel[index] + (this->kernel[index + 1] - this->kernel[index]) * (position - index)) : 0.0f);
+				weightSum += this->weights[j];
+			}
+			// normalizing keeps the gain at 1 and also covers the truncated kernel at the beginning and end
+			if (weightSum <= 0.0f)
+			{
+				weightSum = 1.0f;
+			}
+			input = &this->history[(int)(first - this->historyStart) * this->channels];
+			for_iter (c, 0, this->channels)
+			{
+				sum = 0.0f;
+				for_iter (j, 0, count)
+				{
+					sum += input[j * this->channels + c] * this->weights[j];
+				}
+				Pcm::fromFloat(sum / weightSum, output[i * this->channels + c]);
+			}
+		}
+	}
+
+	int Resampler::_write(hstream& output, int outputBitsPerSample, bool final)
+	{
+		// without more input only frames that have the whole kernel available can be calculated, the last ones are calculated with a truncated kernel
+		double limit = (final ? (double)this->inputFrames : this->inputFrames - this->radius);
+		int frames = 0;
+		while ((double)((this->outputFrames + frames) * this->samplingRate) / this->newSamplingRate < limit)
+		{
+			++frames;
+		}
+		if (frames == 0)
+		{
+			return 0;
+		}
+		int size = frames * this->channels * outputBitsPerSample / 8;
+		output.prepareManualWriteRaw(size);
+		unsigned char* data = &output[(int)output.position()];
+		if (outputBitsPerSample == 8)
+		{
+			this->_resample(data, frames);
+		}
+		else if (outputBitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			this->_resample((float*)data, frames);
+		}
+		else
+		{
+			this->_resample((short*)data, frames);
+		}
+		output.seek(size);
+		this->outputFrames += frames;
+		// input before the kernel of the next output frame isn't needed anymore
+		double center = (double)(this->outputFrames * this->samplingRate) / this->newSamplingRate;
+		int64_t start = hclamp((int64_t)ceil(center - this->radius), this->historyStart, this->inputFrames);
+		if (start > this->historyStart)
+		{
+			int kept = (int)(this->inputFrames - start) * this->channels;
+			if (kept > 0)
+			{
+				memmove(this->history, &this->history[(int)(start - this->historyStart) * this->channels], kept * sizeof(float));
+			}
+			this->historyStart = start;
+		}
+		return frames;
+	}
+
+}
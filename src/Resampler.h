@@ -0,0 +1,75 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides a sampling rate converter for PCM data that is fed block by block.
+
+#ifndef XAL_RESAMPLER_H
+#define XAL_RESAMPLER_H
+
+#include <hltypes/hstream.h>
+
+#include "xalExport.h"
+
+#define RESAMPLER_ZERO_CROSSINGS 16 // kernel half-width in samples of the lower sampling rate
+#define RESAMPLER_CUTOFF 0.9 // relative to the lower Nyquist frequency, leaves room for the transition band
+#define RESAMPLER_TABLE_RESOLUTION 256 // kernel values per sample of the lower sampling rate
+
+namespace xal
+{
+	/// @brief Converts the sampling rate of PCM data with a windowed sinc kernel, input that is still needed by the kernel is kept between blocks.
+	class Resampler
+	{
+	public:
+		Resampler(int channels, int samplingRate, int newSamplingRate);
+		~Resampler();
+
+		/// @return True if the bits per sample can be used as input or output.
+		static bool isSupported(int bitsPerSample);
+
+		/// @brief Processes interleaved PCM data and writes all output frames that can already be calculated.
+		/// @param[in] data PCM data.
+		/// @param[in] frames Number of frames.
+		/// @param[in] bitsPerSample Bits per sample of the input.
+		/// @param[out] output Stream that the resampled data is written to at its current position.
+		/// @param[in] outputBitsPerSample Bits per sample of the output.
+		/// @return Number of written frames.
+		int process(const unsigned char* data, int frames, int bitsPerSample, hstream& output, int outputBitsPerSample);
+		/// @brief Writes the remaining output frames after the last block of input.
+		/// @param[out] output Stream that the resampled data is written to at its current position.
+		/// @param[in] outputBitsPerSample Bits per sample of the output.
+		/// @return Number of written frames.
+		int flush(hstream& output, int outputBitsPerSample);
+
+	protected:
+		int channels;
+		int samplingRate;
+		int newSamplingRate;
+		double step;
+		double radius;
+		int tableSize;
+		float* kernel;
+		float* weights;
+		float* history;
+		int historyCapacity;
+		int64_t historyStart;
+		int64_t inputFrames;
+		int64_t outputFrames;
+
+		template <typename T>
+		void _append(const T* data, int frames);
+		template <typename T>
+		void _resample(T* output, int frames);
+		int _write(hstream& output, int outputBitsPerSample, bool final);
+
+	};
+
+}
+
+#endif
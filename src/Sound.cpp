@@ -12,19 +12,42 @@
 #include <hltypes/hstring.h>
 
 #include "AudioManager.h"
+#include "Bank.h"
 #include "Buffer.h"
 #include "Category.h"
+#include "LoudnessMeter.h"
+#include "MetaDataCache.h"
 #include "Sound.h"
 #include "Source.h"
 #include "xal.h"
 
 namespace xal
 {
+	// Full and Async buffers start loading as soon as they are created, all others only do something once a Player uses them
+	static bool _isDeferred(Category* category)
+	{
+		BufferMode mode = category->getBufferMode();
+		return (mode != BufferMode::Full && mode != BufferMode::Async);
+	}
+
 	Sound::Sound(chstr filename, Category* category, chstr prefix)
 	{
 		this->filename = filename;
 		this->category = category;
-		this->buffer = xal::manager->_createBuffer(this);
+		this->bankEntry = NULL;
+		this->buffer = NULL;
+		this->deferred = _isDeferred(category);
+		this->playerCount = 0;
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
+		if (!this->deferred)
+		{
+			this->buffer = xal::manager->_createBuffer(this);
+		}
 		// extracting filename without extension and prepending the prefix
 		this->name = prefix + hresource::withoutExtension(hrdir::baseName(filename));
 	}
@@ -33,6 +56,15 @@ namespace xal
 	{
 		this->filename = "";
 		this->category = category;
+		this->bankEntry = NULL;
+		this->deferred = false;
+		this->playerCount = 0;
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
 		this->buffer = xal::manager->_createBuffer(category, data, size, channels, samplingRate, bitsPerSample);
 		// extracting filename without extension and prepending the prefix
 		this->name = name;
@@ -40,18 +72,97 @@ namespace xal
 		xal::manager->_convertStream("manual sound in category '" + name + "'", channels, samplingRate, bitsPerSample, this->buffer->getStream());
 	}
 
+	Sound::Sound(chstr name, Category* category, unsigned char* data, int64_t size, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData)
+	{
+		this->filename = "";
+		this->category = category;
+		this->bankEntry = NULL;
+		this->deferred = false;
+		this->playerCount = 0;
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
+		// no conversion here, the data is converted chunk by chunk while streaming
+		this->buffer = xal::manager->_createBuffer(category, data, size, channels, samplingRate, bitsPerSample, releaseCallback, userData);
+		this->name = name;
+	}
+
+	Sound::Sound(chstr name, Category* category, GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample)
+	{
+		this->filename = "";
+		this->category = category;
+		this->bankEntry = NULL;
+		this->deferred = false;
+		this->playerCount = 0;
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
+		this->buffer = xal::manager->_createBuffer(category, callback, userData, channels, samplingRate, bitsPerSample);
+		this->name = name;
+	}
+
+	Sound::Sound(const BankEntry& bankEntry, Category* category, chstr prefix)
+	{
+		// the logical filename is only used for the format and for logging, the data is accessed through the bank
+		this->filename = hrdir::joinPath(bankEntry.bankFilename, bankEntry.filename);
+		this->category = category;
+		this->bankEntry = new BankEntry(bankEntry);
+		this->buffer = NULL;
+		this->deferred = _isDeferred(category);
+		this->playerCount = 0;
+		this->loadedMetaData = false;
+		this->size = 0;
+		this->channels = 2;
+		this->samplingRate = 44100;
+		this->bitsPerSample = 16;
+		this->duration = 0.0f;
+		if (!this->deferred)
+		{
+			this->buffer = xal::manager->_createBuffer(this);
+		}
+		this->name = prefix + hresource::withoutExtension(hrdir::baseName(bankEntry.filename));
+	}
+
 	Sound::~Sound()
 	{
-		xal::manager->_destroyBuffer(this->buffer);
+		if (this->buffer != NULL)
+		{
+			if (this->deferred)
+			{
+				xal::manager->idleDeferredSounds -= this;
+			}
+			xal::manager->_destroyBuffer(this->buffer);
+		}
+		if (this->bankEntry != NULL)
+		{
+			delete this->bankEntry;
+		}
 	}
 	
-	int Sound::getSize()
+	int64_t Sound::getSize()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->_tryLoadMetaData();
+			return this->size;
+		}
 		return this->buffer->getSize();
 	}
 
-	int Sound::getSourceSize()
+	int64_t Sound::getSourceSize()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			return 0;
+		}
 		Source* source = this->buffer->getSource();
 		if (source == NULL)
 		{
@@ -62,42 +173,101 @@ namespace xal
 
 	int Sound::getChannels()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->_tryLoadMetaData();
+			return this->channels;
+		}
 		return this->buffer->getChannels();
 	}
 
 	int Sound::getSamplingRate()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->_tryLoadMetaData();
+			return this->samplingRate;
+		}
 		return this->buffer->getSamplingRate();
 	}
 
 	int Sound::getBitsPerSample()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->_tryLoadMetaData();
+			return this->bitsPerSample;
+		}
 		return this->buffer->getBitsPerSample();
 	}
 
 	float Sound::getDuration()
 	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->_tryLoadMetaData();
+			return this->duration;
+		}
 		return this->buffer->getDuration();
 	}
 
+	int Sound::getSavedSize()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL ? this->buffer->getSavedSize() : 0);
+	}
+
+	float Sound::getLoudness()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL ? this->buffer->getLoudness() : LOUDNESS_MINIMUM);
+	}
+
+	float Sound::getTruePeak()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL ? this->buffer->getTruePeak() : LOUDNESS_MINIMUM);
+	}
+
+	bool Sound::isLoudnessAnalyzed()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL && this->buffer->isLoudnessAnalyzed());
+	}
+
 	Format Sound::getFormat() const
 	{
+		// the Buffer of a deferred Sound can be released at any time, but the format is known from the filename anyway
+		if (this->deferred || this->buffer == NULL)
+		{
+			return Buffer::findFormat(this->filename);
+		}
 		return this->buffer->getFormat();
 	}
 	
 	float Sound::getBufferIdleTime()
 	{
-		return this->buffer->getIdleTime();
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL ? this->buffer->getIdleTime() : 0.0f);
 	}
 
 	bool Sound::isStreamed() const
 	{
-		return this->buffer->isStreamed();
+		if (this->deferred || this->buffer == NULL)
+		{
+			return (this->category->getBufferMode() == BufferMode::Streamed || this->category->isAdpcmStorage());
+		}
+		return (this->buffer->isStreamed() || this->buffer->isAdpcm());
 	}
 
 	bool Sound::isLoaded()
 	{
-		return this->buffer->isLoaded();
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		return (this->buffer != NULL && this->buffer->isLoaded());
 	}
 
 	void Sound::readPcmData(hstream& output)
@@ -105,4 +275,84 @@ namespace xal
 		Buffer(this).readPcmData(output);
 	}
 
+	void Sound::_tryLoadMetaData()
+	{
+		if (this->loadedMetaData)
+		{
+			return;
+		}
+		// metadata of Sounds without Buffer comes from the bank or the metadata cache so nothing has to be opened
+		if (this->bankEntry != NULL && this->bankEntry->floatOutput == MetaDataCache::isFloatOutput())
+		{
+			this->size = this->bankEntry->size;
+			this->channels = this->bankEntry->channels;
+			this->samplingRate = this->bankEntry->samplingRate;
+			this->bitsPerSample = this->bankEntry->bitsPerSample;
+			this->duration = this->bankEntry->duration;
+			this->loadedMetaData = true;
+			return;
+		}
+		if (this->bankEntry == NULL)
+		{
+			int64_t fileSize = 0;
+			int64_t modificationTime = 0;
+			Buffer::findFileInfo(this->filename, fileSize, modificationTime);
+			MetaData metaData;
+			if (MetaDataCache::find(this->filename, fileSize, modificationTime, metaData))
+			{
+				this->size = metaData.size;
+				this->channels = metaData.channels;
+				this->samplingRate = metaData.samplingRate;
+				this->bitsPerSample = metaData.bitsPerSample;
+				this->duration = metaData.duration;
+				this->loadedMetaData = true;
+				return;
+			}
+		}
+		// a temporary Buffer doesn't load anything, it only probes the headers
+		Buffer buffer(this);
+		this->size = buffer.getSize();
+		this->channels = buffer.getChannels();
+		this->samplingRate = buffer.getSamplingRate();
+		this->bitsPerSample = buffer.getBitsPerSample();
+		this->duration = buffer.getDuration();
+		this->loadedMetaData = true;
+	}
+
+	Buffer* Sound::_bindPlayer()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->buffer == NULL)
+		{
+			this->buffer = xal::manager->_createBuffer(this);
+		}
+		else if (this->deferred && this->playerCount == 0)
+		{
+			xal::manager->idleDeferredSounds -= this;
+		}
+		++this->playerCount;
+		return this->buffer;
+	}
+
+	void Sound::_unbindPlayer()
+	{
+		--this->playerCount;
+		// only Sounds without Players have to be checked for releasing their Buffer
+		if (this->deferred && this->playerCount == 0 && this->buffer != NULL)
+		{
+			xal::manager->idleDeferredSounds += this;
+		}
+	}
+
+	void Sound::_releaseBuffer()
+	{
+		hmutex::ScopeLock lock(&this->bufferMutex);
+		if (this->deferred && this->buffer != NULL)
+		{
+			xal::manager->idleDeferredSounds -= this;
+			xal::manager->_destroyBuffer(this->buffer);
+			this->buffer = NULL;
+		}
+	}
+
 }
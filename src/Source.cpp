@@ -12,6 +12,8 @@
 #include <hltypes/hresource.h>
 
 #include "AudioManager.h"
+#include "MappedStream.h"
+#include "ProviderStream.h"
 #include "Source.h"
 #include "xal.h"
 
@@ -19,12 +21,17 @@ namespace xal
 {
 	Source::Source(chstr filename, SourceMode sourceMode, BufferMode bufferMode) :
 		streamOpen(false),
+		streamMapped(false),
 		size(0),
 		channels(2),
 		samplingRate(44100),
 		bitsPerSample(16),
 		duration(0.0f),
-		stream(NULL)
+		adpcmBlockSize(0),
+		stream(NULL),
+		bankOffset(0),
+		bankSize(0),
+		modificationTime(0)
 	{
 		this->filename = filename;
 		this->sourceMode = sourceMode;
@@ -39,18 +46,25 @@ namespace xal
 		}
 	}
 
-	int Source::getRamSize() const
+	int64_t Source::getRamSize() const
 	{
 		if (this->sourceMode == SourceMode::Ram && this->stream != NULL)
 		{
-			return (int)this->stream->size();
+			return this->stream->size();
 		}
 		return 0;
 	}
 
+	void Source::setBankRange(chstr bankFilename, int64_t offset, int64_t size)
+	{
+		this->bankFilename = bankFilename;
+		this->bankOffset = offset;
+		this->bankSize = size;
+	}
+
 	bool Source::open()
 	{
-		if (!hresource::exists(this->filename))
+		if (this->bankFilename == "" && !ProviderStream::exists(this->filename))
 		{
 			hlog::error(logTag, "Unable to open: " + this->filename);
 			this->close();
@@ -58,18 +72,65 @@ namespace xal
 		}
 		if (this->stream == NULL)
 		{
-			hresource* resource = new hresource;
-			resource->open(this->filename);
-			if (this->sourceMode == SourceMode::Ram || this->bufferMode == BufferMode::Async)
+			this->streamMapped = false;
+		}
+		if (this->stream == NULL && this->sourceMode == SourceMode::Mapped)
+		{
+			MappedStream* mappedStream = new MappedStream();
+			bool mapped = false;
+			if (this->bankFilename == "")
+			{
+				mapped = mappedStream->open(this->filename);
+			}
+			else
+			{
+				mapped = mappedStream->open(this->bankFilename, this->bankOffset, this->bankSize);
+			}
+			if (mapped)
+			{
+				this->stream = mappedStream;
+				this->streamMapped = true;
+			}
+			else
+			{
+				delete mappedStream;
+				// e.g. files inside of archives can only be read through hresource
+				hlog::warn(logTag, "Unable to memory-map, reading through hresource instead: " + (this->bankFilename == "" ? this->filename : this->bankFilename));
+			}
+		}
+		if (this->stream == NULL && this->bankFilename != "")
+		{
+			// the data of a bank file that can't be mapped is copied so the decoders see it as a file of its own
+			hresource resource;
+			resource.open(this->bankFilename);
+			resource.seek(this->bankOffset, hseek::Start);
+			hstream* data = new hstream();
+			data->writeRaw(resource, (int)this->bankSize);
+			data->rewind();
+			this->stream = data;
+		}
+		if (this->stream == NULL)
+		{
+			hsbase* resource = ProviderStream::create(this->filename);
+			if (resource == NULL)
+			{
+				hlog::error(logTag, "Unable to open: " + this->filename);
+				return this->streamOpen;
+			}
+			// data that an IoProvider already keeps in memory is decoded directly without copying it
+			ProviderStream* providerStream = dynamic_cast<ProviderStream*>(resource);
+			bool mapped = (providerStream != NULL && providerStream->isMapped());
+			if (!mapped && (this->sourceMode == SourceMode::Ram || this->bufferMode == BufferMode::Async))
 			{
 				this->stream = new hstream();
 				this->stream->writeRaw(*resource);
 				delete resource;
 				this->stream->rewind();
 			}
-			else // if sourceMode == DISK
+			else // if sourceMode == DISK or MAPPED
 			{
 				this->stream = resource;
+				this->streamMapped = mapped;
 			}
 		}
 		else
@@ -80,14 +141,43 @@ namespace xal
 		return this->streamOpen;
 	}
 
+	bool Source::probe()
+	{
+		if (this->streamOpen)
+		{
+			return true;
+		}
+		// only the headers are needed so the file is never copied to RAM and no seek index is loaded
+		SourceMode sourceMode = this->sourceMode;
+		BufferMode bufferMode = this->bufferMode;
+		if (this->sourceMode == SourceMode::Ram)
+		{
+			this->sourceMode = SourceMode::Disk;
+		}
+		this->bufferMode = BufferMode::Full;
+		bool result = this->_probe();
+		this->sourceMode = sourceMode;
+		this->bufferMode = bufferMode;
+		return result;
+	}
+
+	bool Source::_probe()
+	{
+		// formats that only parse their headers when opening don't need anything special
+		bool result = this->open();
+		this->close();
+		return result;
+	}
+
 	void Source::close()
 	{
 		if (this->streamOpen)
 		{
-			if (this->sourceMode == SourceMode::Disk)
+			if (this->sourceMode == SourceMode::Disk || this->sourceMode == SourceMode::Mapped)
 			{
 				delete this->stream;
 				this->stream = NULL;
+				this->streamMapped = false;
 			}
 			this->streamOpen = false;
 		}
@@ -101,6 +191,35 @@ namespace xal
 		}
 	}
 	
+	bool Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		// sources without random access decode and discard everything up to the requested sample
+		this->rewind();
+		int64_t remaining = sample * this->channels * this->bitsPerSample / 8;
+		hstream discarded;
+		int read = 0;
+		while (remaining > 0)
+		{
+			discarded.clear(STREAM_BUFFER_SIZE);
+			read = this->loadChunk(discarded, (int)hmin(remaining, (int64_t)STREAM_BUFFER_SIZE));
+			if (read <= 0)
+			{
+				return false;
+			}
+			remaining -= read;
+		}
+		return true;
+	}
+
+	void Source::_getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const
+	{
+		xal::manager->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+	}
+	
 	bool Source::load(hstream& output)
 	{
 		hlog::write(logTag, "Loading file: " + this->filename);
@@ -121,5 +240,10 @@ namespace xal
 		}
 		return 1; // means that "something" was read
 	}
+
+	bool Source::loadAdpcm(hstream& output)
+	{
+		return false; // only sources with IMA-ADPCM data can provide it directly
+	}
 	
 }
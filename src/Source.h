@@ -35,30 +35,50 @@ namespace xal
 		HL_DEFINE_GET(SourceMode, sourceMode, SourceMode);
 		HL_DEFINE_GET(BufferMode, bufferMode, BufferMode);
 		HL_DEFINE_IS(streamOpen, Open);
-		HL_DEFINE_GET(int, size, Size);
+		HL_DEFINE_IS(streamMapped, StreamMapped);
+		HL_DEFINE_GET(int64_t, size, Size);
 		HL_DEFINE_GET(int, channels, Channels);
 		HL_DEFINE_GET(int, samplingRate, SamplingRate);
 		HL_DEFINE_GET(int, bitsPerSample, BitsPerSample);
 		HL_DEFINE_GET(float, duration, Duration);
-		int getRamSize() const;
+		HL_DEFINE_GET(int, adpcmBlockSize, AdpcmBlockSize);
+		HL_DEFINE_GET(hstr, bankFilename, BankFilename);
+		HL_DEFINE_GET(int64_t, bankOffset, BankOffset);
+		HL_DEFINE_GET(int64_t, bankSize, BankSize);
+		HL_DEFINE_GETSET(int64_t, modificationTime, ModificationTime);
+		int64_t getRamSize() const;
+
+		void setBankRange(chstr bankFilename, int64_t offset, int64_t size);
 
 		virtual bool open();
 		virtual void close();
+		bool probe();
 		virtual void rewind();
+		virtual bool seek(int64_t sample);
 		virtual bool load(hstream& output);
 		virtual int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE);
+		virtual bool loadAdpcm(hstream& output);
 		
 	protected:
 		hstr filename;
 		SourceMode sourceMode;
 		BufferMode bufferMode;
 		bool streamOpen;
-		int size;
+		bool streamMapped;
+		int64_t size;
 		int channels;
 		int samplingRate;
 		int bitsPerSample;
 		float duration;
+		int adpcmBlockSize;
 		hsbase* stream;
+		hstr bankFilename;
+		int64_t bankOffset;
+		int64_t bankSize;
+		int64_t modificationTime;
+
+		virtual bool _probe();
+		void _getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const;
 
 	};
 
@@ -21,5 +21,6 @@
 	#define STREAM_BUFFER_SIZE 16384 // equal to any power of 2
 #endif
 #define STREAM_BUFFER (STREAM_BUFFER_COUNT * STREAM_BUFFER_SIZE)
+#define FLOAT_BITS_PER_SAMPLE 32 // 32-bit samples are always IEEE float within XAL
 
 #endif
@@ -0,0 +1,168 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "Adpcm.h"
+#include "ADPCM_Source.h"
+#include "AudioManager.h"
+#include "Buffer.h"
+#include "xal.h"
+
+namespace xal
+{
+	ADPCM_Source::ADPCM_Source(Buffer* buffer) :
+		Source(buffer->getFilename(), SourceMode::Ram, BufferMode::Streamed),
+		blockIndex(0),
+		decodedFrames(0),
+		decodedPosition(0),
+		framePosition(0)
+	{
+		this->buffer = buffer;
+	}
+
+	ADPCM_Source::~ADPCM_Source()
+	{
+		this->close();
+	}
+
+	bool ADPCM_Source::open()
+	{
+		// the compressed data is shared by all players so it's only loaded once
+		this->buffer->prepare();
+		this->adpcmBlockSize = this->buffer->getAdpcmBlockSize();
+		if (!this->buffer->isLoaded() || this->adpcmBlockSize == 0)
+		{
+			hlog::error(logTag, "No IMA-ADPCM data available: " + this->filename);
+			return false;
+		}
+		this->channels = this->buffer->getChannels();
+		this->samplingRate = this->buffer->getSamplingRate();
+		this->bitsPerSample = 16;
+		this->size = this->buffer->getSize();
+		this->duration = this->buffer->getDuration();
+		this->decoded.clear();
+		this->decoded.add(0, Adpcm::calcBlockFrames(this->adpcmBlockSize, this->channels) * this->channels);
+		this->streamOpen = true;
+		this->rewind();
+		return this->streamOpen;
+	}
+
+	void ADPCM_Source::close()
+	{
+		this->decoded.clear();
+		Source::close();
+	}
+
+	void ADPCM_Source::rewind()
+	{
+		this->blockIndex = 0;
+		this->decodedFrames = 0;
+		this->decodedPosition = 0;
+		this->framePosition = 0;
+	}
+
+	bool ADPCM_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		this->rewind();
+		int totalFrames = (int)(this->size / (this->channels * 2));
+		int frames = (int)hmin(sample, (int64_t)totalFrames);
+		int blockFrames = Adpcm::calcBlockFrames(this->adpcmBlockSize, this->channels);
+		this->blockIndex = frames / blockFrames;
+		this->framePosition = this->blockIndex * blockFrames;
+		frames %= blockFrames;
+		if (frames > 0)
+		{
+			hstream& data = this->buffer->getStream();
+			int dataSize = (int)data.size();
+			int offset = this->blockIndex * this->adpcmBlockSize;
+			if (offset >= dataSize)
+			{
+				return false;
+			}
+			this->decodedFrames = Adpcm::decodeBlock(&data[offset], hmin(this->adpcmBlockSize, dataSize - offset), this->channels, &this->decoded[0]);
+			this->decodedPosition = hmin(frames, this->decodedFrames);
+			this->framePosition += this->decodedPosition;
+			++this->blockIndex;
+		}
+		return true;
+	}
+
+	bool ADPCM_Source::load(hstream& output)
+	{
+		if (!Source::load(output))
+		{
+			return false;
+		}
+		int written = this->_read(output, (int)this->size);
+		if (written > 0)
+		{
+			output.seek(-written);
+			return true;
+		}
+		return false;
+	}
+
+	int ADPCM_Source::loadChunk(hstream& output, int size)
+	{
+		if (Source::loadChunk(output, size) == 0)
+		{
+			return 0;
+		}
+		int written = this->_read(output, size);
+		if (written > 0)
+		{
+			output.seek(-written);
+		}
+		return written;
+	}
+
+	int ADPCM_Source::_read(hstream& output, int size)
+	{
+		hstream& data = this->buffer->getStream();
+		int dataSize = (int)data.size();
+		int frameSize = this->channels * 2;
+		int totalFrames = (int)(this->size / frameSize);
+		int remaining = size / frameSize;
+		int written = 0;
+		int offset = 0;
+		int count = 0;
+		// whole blocks are decoded at once, only the copy into the output is split up
+		while (remaining > 0 && this->framePosition < totalFrames)
+		{
+			if (this->decodedPosition >= this->decodedFrames)
+			{
+				offset = this->blockIndex * this->adpcmBlockSize;
+				if (offset >= dataSize)
+				{
+					break;
+				}
+				this->decodedFrames = Adpcm::decodeBlock(&data[offset], hmin(this->adpcmBlockSize, dataSize - offset), this->channels, &this->decoded[0]);
+				this->decodedPosition = 0;
+				++this->blockIndex;
+				if (this->decodedFrames == 0)
+				{
+					break;
+				}
+			}
+			count = hmin(hmin(remaining, this->decodedFrames - this->decodedPosition), totalFrames - this->framePosition);
+			written += output.writeRaw((unsigned char*)&this->decoded[this->decodedPosition * this->channels], count * frameSize);
+			this->decodedPosition += count;
+			this->framePosition += count;
+			remaining -= count;
+		}
+		return written;
+	}
+
+}
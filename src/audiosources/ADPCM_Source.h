@@ -0,0 +1,54 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides a source for IMA-ADPCM data stored in another Buffer.
+
+#ifndef XAL_ADPCM_SOURCE_H
+#define XAL_ADPCM_SOURCE_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
+#include "Source.h"
+#include "xalExport.h"
+
+namespace xal
+{
+	class Buffer;
+
+	class xalExport ADPCM_Source : public Source
+	{
+	public:
+		ADPCM_Source(Buffer* buffer);
+		~ADPCM_Source();
+
+		bool open() override;
+		void close() override;
+		void rewind() override;
+		bool seek(int64_t sample) override;
+		bool load(hstream& output) override;
+		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
+
+	protected:
+		Buffer* buffer;
+		harray<short> decoded;
+		int blockIndex;
+		int decodedFrames;
+		int decodedPosition;
+		int framePosition;
+
+		int _read(hstream& output, int size);
+
+	};
+
+}
+
+#endif
@@ -7,13 +7,73 @@
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
 #ifdef _FORMAT_FLAC
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
 #include "FLAC_Source.h"
+#include "Utility.h"
 #include "xal.h"
 
+// metadata block types
+#define FLAC_BLOCK_STREAMINFO 0
+#define FLAC_BLOCK_SEEKTABLE 3
+#define FLAC_STREAMINFO_SIZE 34
+#define FLAC_SEEKPOINT_SIZE 18
+#define FLAC_SEEKPOINT_PLACEHOLDER 0xFFFFFFFFFFFFFFFFULL
+// channel assignments
+#define FLAC_CHANNELS_LEFT_SIDE 8
+#define FLAC_CHANNELS_SIDE_RIGHT 9
+#define FLAC_CHANNELS_MID_SIDE 10
+
 namespace xal
 {
+	static int64_t _readBigEndian(const unsigned char* data, int size)
+	{
+		int64_t result = 0;
+		for_iter (i, 0, size)
+		{
+			result = (result << 8) | data[i];
+		}
+		return result;
+	}
+
+	unsigned char FLAC_Source::crc8Table[256];
+	unsigned short FLAC_Source::crc16Table[256];
+	bool FLAC_Source::crcTablesCreated = FLAC_Source::_createCrcTables();
+
+	static int _getBitLength(unsigned int value)
+	{
+		int result = 0;
+		while (value > 0)
+		{
+			++result;
+			value >>= 1;
+		}
+		return result;
+	}
+
 	FLAC_Source::FLAC_Source(chstr filename, SourceMode sourceMode, BufferMode bufferMode) :
-		Source(filename, sourceMode, bufferMode)
+		Source(filename, sourceMode, bufferMode),
+		dataBitsPerSample(0),
+		totalSamples(0),
+		firstFramePosition(0),
+		blockCapacity(0),
+		nominalBlockSize(0),
+		blockSize(0),
+		blockPosition(0),
+		blockSample(0),
+		readBuffer(NULL),
+		readSize(0),
+		readPosition(0),
+		bitCache(0),
+		bitCount(0),
+		crc8(0),
+		crc16(0)
 	{
 	}
 
@@ -29,17 +89,123 @@ namespace xal
 		{
 			return false;
 		}
-		// TODO - implement
+		// data will be reloaded, clearing it here
+		this->channels = 0;
+		this->samplingRate = 0;
+		this->bitsPerSample = 0;
+		this->size = 0;
+		this->duration = 0.0f;
+		this->dataBitsPerSample = 0;
+		this->totalSamples = 0;
+		this->seekPointSamples.clear();
+		this->seekPointOffsets.clear();
+		unsigned char buffer[FLAC_STREAMINFO_SIZE] = {0};
+		this->stream->readRaw(buffer, 4);
+		if (memcmp(buffer, "fLaC", 4) != 0)
+		{
+			hlog::error(logTag, "FLAC: not a FLAC file: " + this->filename);
+			this->close();
+			return false;
+		}
+		int minBlockSize = 0;
+		int maxBlockSize = 0;
+		bool last = false;
+		int type = 0;
+		int size = 0;
+		while (!last)
+		{
+			if (this->stream->readRaw(buffer, 4) < 4)
+			{
+				hlog::error(logTag, "FLAC: unexpected end of metadata: " + this->filename);
+				this->close();
+				return false;
+			}
+			last = ((buffer[0] & 0x80) != 0);
+			type = (buffer[0] & 0x7F);
+			size = (int)_readBigEndian(&buffer[1], 3);
+			if (type == FLAC_BLOCK_STREAMINFO && size >= FLAC_STREAMINFO_SIZE)
+			{
+				this->stream->readRaw(buffer, FLAC_STREAMINFO_SIZE);
+				minBlockSize = (int)_readBigEndian(buffer, 2);
+				maxBlockSize = (int)_readBigEndian(&buffer[2], 2);
+				this->samplingRate = (int)(_readBigEndian(&buffer[10], 3) >> 4);
+				this->channels = ((buffer[12] >> 1) & 0x7) + 1;
+				this->dataBitsPerSample = (((buffer[12] & 0x1) << 4) | (buffer[13] >> 4)) + 1;
+				this->totalSamples = (_readBigEndian(&buffer[13], 5) & 0xFFFFFFFFFLL);
+				size -= FLAC_STREAMINFO_SIZE; // the MD5 signature is skipped below
+			}
+			else if (type == FLAC_BLOCK_SEEKTABLE)
+			{
+				int count = size / FLAC_SEEKPOINT_SIZE;
+				for_iter (i, 0, count)
+				{
+					this->stream->readRaw(buffer, FLAC_SEEKPOINT_SIZE);
+					if ((uint64_t)_readBigEndian(buffer, 8) != FLAC_SEEKPOINT_PLACEHOLDER)
+					{
+						this->seekPointSamples += _readBigEndian(buffer, 8);
+						this->seekPointOffsets += _readBigEndian(&buffer[8], 8);
+					}
+				}
+				size -= count * FLAC_SEEKPOINT_SIZE;
+			}
+			if (size > 0)
+			{
+				this->stream->seek(size);
+			}
+		}
+		if (this->channels == 0 || this->samplingRate == 0 || this->dataBitsPerSample < 4 || this->dataBitsPerSample > 24)
+		{
+			hlog::errorf(logTag, "FLAC: unsupported format with %d bits per sample: %s", this->dataBitsPerSample, this->filename.cStr());
+			this->close();
+			return false;
+		}
+		this->firstFramePosition = this->stream->position();
+		// 8 and 16 bit data is passed on as it is, higher resolutions are converted to float if the audio manager can use it
+		if (this->dataBitsPerSample <= 8)
+		{
+			this->bitsPerSample = 8;
+		}
+		else if (this->dataBitsPerSample <= 16)
+		{
+			this->bitsPerSample = 16;
+		}
+		else
+		{
+			int channels = this->channels;
+			int samplingRate = this->samplingRate;
+			this->bitsPerSample = FLOAT_BITS_PER_SAMPLE;
+			this->_getConvertedFormat(channels, samplingRate, this->bitsPerSample);
+			if (this->bitsPerSample != FLOAT_BITS_PER_SAMPLE)
+			{
+				this->bitsPerSample = 16;
+			}
+		}
+		this->size = this->totalSamples * this->channels * this->bitsPerSample / 8;
+		this->duration = (float)((double)this->totalSamples / this->samplingRate);
+		this->blockCapacity = hmax(maxBlockSize, 4608); // 4608 is the largest block size of the common presets
+		// the minimum doesn't include the last frame so both are the same for streams with a fixed block size
+		this->nominalBlockSize = (minBlockSize == maxBlockSize ? maxBlockSize : 0);
+		this->samples.clear();
+		this->samples.add(0, this->blockCapacity * this->channels);
+		if (this->readBuffer == NULL)
+		{
+			this->readBuffer = new unsigned char[FLAC_READ_BUFFER_SIZE];
+		}
+		this->_resetReader();
+		this->blockSize = 0;
+		this->blockPosition = 0;
+		this->blockSample = 0;
 		return this->streamOpen;
 	}
 
 	void FLAC_Source::close()
 	{
-		if (this->streamOpen)
+		if (this->readBuffer != NULL)
 		{
-			this->streamOpen = false;
-			// TODO - implement
+			delete[] this->readBuffer;
+			this->readBuffer = NULL;
 		}
+		this->samples.clear();
 		Source::close();
 	}
 
@@ -47,7 +213,7 @@ namespace xal
 	{
 		if (this->streamOpen)
 		{
-			// TODO - implement
+			this->seek(0);
 		}
 	}
 
@@ -57,7 +223,14 @@ namespace xal
 		{
 			return false;
 		}
-		// TODO - implement
+		int remaining = (int)this->size;
+		output.prepareManualWriteRaw(remaining);
+		char* buffer = (char*)&output[(int)output.position()];
+		int read = this->_read(buffer, remaining);
+		if (read < remaining)
+		{
+			memset(&buffer[read], 0, remaining - read);
+		}
 		return true;
 	}
 
@@ -67,8 +240,524 @@ namespace xal
 		{
 			return 0;
 		}
-		// TODO - implement
-		return 0;
+		output.prepareManualWriteRaw(size);
+		int result = this->_read((char*)&output[(int)output.position()], size);
+		if (result < size)
+		{
+			output.truncate(output.position() + (int64_t)result); // if there wasn't enough data to fill the entire ouput buffer
+		}
+		return result;
+	}
+
+	bool FLAC_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		// the closest seek point before the requested sample is used as starting point
+		int64_t offset = 0;
+		int64_t start = 0;
+		for_iter (i, 0, this->seekPointSamples.size())
+		{
+			if (this->seekPointSamples[i] <= sample && this->seekPointSamples[i] >= start)
+			{
+				start = this->seekPointSamples[i];
+				offset = this->seekPointOffsets[i];
+			}
+		}
+		this->stream->seek(this->firstFramePosition + offset, hseek::Start);
+		this->_resetReader();
+		this->blockSize = 0;
+		this->blockPosition = 0;
+		this->blockSample = start;
+		// frames are decoded until the one containing the requested sample is found
+		while (true)
+		{
+			if (!this->_decodeFrame())
+			{
+				return false;
+			}
+			if (this->blockSample + this->blockSize > sample)
+			{
+				this->blockPosition = (int)hmax(sample - this->blockSample, (int64_t)0);
+				return true;
+			}
+		}
+	}
+
+	int FLAC_Source::_read(char* output, int size)
+	{
+		int frameSize = this->channels * this->bitsPerSample / 8;
+		int frames = size / frameSize;
+		int written = 0;
+		int count = 0;
+		while (written < frames)
+		{
+			if (this->blockPosition >= this->blockSize)
+			{
+				if (this->totalSamples > 0 && this->blockSample + this->blockSize >= this->totalSamples)
+				{
+					break;
+				}
+				this->blockSample += this->blockSize;
+				if (!this->_decodeFrame())
+				{
+					break;
+				}
+			}
+			count = hmin(frames - written, this->blockSize - this->blockPosition);
+			this->_writeFrames(&output[written * frameSize], this->blockPosition, count);
+			this->blockPosition += count;
+			written += count;
+		}
+		return (written * frameSize);
+	}
+
+	void FLAC_Source::_writeFrames(char* output, int offset, int count)
+	{
+		const int* channel = NULL;
+		int shift = 0;
+		if (this->bitsPerSample == 8)
+		{
+			unsigned char* data = (unsigned char*)output;
+			shift = 8 - this->dataBitsPerSample;
+			for_iter (c, 0, this->channels)
+			{
+				channel = &this->samples[c * this->blockCapacity + offset];
+				for_iter (i, 0, count)
+				{
+					data[i * this->channels + c] = (unsigned char)((channel[i] << shift) + 128); // 8 bit PCM data is unsigned
+				}
+			}
+		}
+		else if (this->bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			float* data = (float*)output;
+			float factor = 1.0f / (1 << (this->dataBitsPerSample - 1));
+			for_iter (c, 0, this->channels)
+			{
+				channel = &this->samples[c * this->blockCapacity + offset];
+				for_iter (i, 0, count)
+				{
+					data[i * this->channels + c] = channel[i] * factor;
+				}
+			}
+		}
+		else if (this->dataBitsPerSample <= 16)
+		{
+			short* data = (short*)output;
+			shift = 16 - this->dataBitsPerSample;
+			for_iter (c, 0, this->channels)
+			{
+				channel = &this->samples[c * this->blockCapacity + offset];
+				for_iter (i, 0, count)
+				{
+					data[i * this->channels + c] = (short)(channel[i] << shift);
+				}
+			}
+		}
+		else
+		{
+			short* data = (short*)output;
+			shift = this->dataBitsPerSample - 16;
+			for_iter (c, 0, this->channels)
+			{
+				channel = &this->samples[c * this->blockCapacity + offset];
+				for_iter (i, 0, count)
+				{
+					data[i * this->channels + c] = (short)(channel[i] >> shift);
+				}
+			}
+		}
+	}
+
+	bool FLAC_Source::_decodeFrame()
+	{
+		unsigned int previous = 0;
+		unsigned int current = 0;
+		bool variableBlockSize = false;
+		int blockSizeCode = 0;
+		int samplingRateCode = 0;
+		int channelAssignment = 0;
+		int sampleSizeCode = 0;
+		unsigned int value = 0;
+		int64_t number = 0;
+		int blockSize = 0;
+		unsigned int crc = 0;
+		while (true)
+		{
+			// frames always start at a byte boundary with a 14 bit sync code
+			this->_alignToByte();
+			previous = 0;
+			while (true)
+			{
+				if (this->_isEndOfData())
+				{
+					return false;
+				}
+				current = this->_readBits(8);
+				if (previous == 0xFF && (current & 0xFE) == 0xF8)
+				{
+					break;
+				}
+				previous = current;
+			}
+			// the checksums start with the sync code
+			this->crc8 = crc8Table[crc8Table[previous] ^ current];
+			this->crc16 = ((crc16Table[previous] << 8) ^ crc16Table[(crc16Table[previous] >> 8) ^ current]) & 0xFFFF;
+			variableBlockSize = ((current & 0x1) != 0);
+			blockSizeCode = this->_readBits(4);
+			samplingRateCode = this->_readBits(4);
+			channelAssignment = this->_readBits(4);
+			sampleSizeCode = this->_readBits(3);
+			this->_readBits(1);
+			// UTF-8 style coded frame or sample number
+			value = this->_readBits(8);
+			number = value;
+			if ((value & 0x80) != 0)
+			{
+				int extra = 0;
+				while ((value & (0x80 >> extra)) != 0 && extra < 7)
+				{
+					++extra;
+				}
+				number = (value & (0x7F >> extra));
+				for_iter (i, 1, extra)
+				{
+					number = (number << 6) | (this->_readBits(8) & 0x3F);
+				}
+			}
+			blockSize = 0;
+			if (blockSizeCode == 1)
+			{
+				blockSize = 192;
+			}
+			else if (blockSizeCode >= 2 && blockSizeCode <= 5)
+			{
+				blockSize = 576 << (blockSizeCode - 2);
+			}
+			else if (blockSizeCode == 6)
+			{
+				blockSize = this->_readBits(8) + 1;
+			}
+			else if (blockSizeCode == 7)
+			{
+				blockSize = this->_readBits(16) + 1;
+			}
+			else if (blockSizeCode >= 8)
+			{
+				blockSize = 256 << (blockSizeCode - 8);
+			}
+			if (samplingRateCode == 12)
+			{
+				this->_readBits(8);
+			}
+			else if (samplingRateCode == 13 || samplingRateCode == 14)
+			{
+				this->_readBits(16);
+			}
+			crc = this->crc8;
+			if (this->_readBits(8) == crc)
+			{
+				break;
+			}
+			// either a corrupted header or sample data that happened to look like a sync code
+			hlog::warn(logTag, "FLAC: frame header CRC mismatch, searching next frame: " + this->filename);
+		}
+		static const int sampleSizes[8] = {0, 8, 12, 0, 16, 20, 24, 0};
+		int bitsPerSample = (sampleSizeCode == 0 ? this->dataBitsPerSample : sampleSizes[sampleSizeCode]);
+		int channels = (channelAssignment < FLAC_CHANNELS_LEFT_SIDE ? channelAssignment + 1 : 2);
+		if (blockSize == 0 || bitsPerSample != this->dataBitsPerSample || channels != this->channels || channelAssignment > FLAC_CHANNELS_MID_SIDE)
+		{
+			hlog::error(logTag, "FLAC: invalid frame header: " + this->filename);
+			return false;
+		}
+		if (blockSize > this->blockCapacity)
+		{
+			this->blockCapacity = blockSize;
+			this->samples.clear();
+			this->samples.add(0, this->blockCapacity * this->channels);
+		}
+		// frame numbers are only used with fixed block sizes, in which case all frames but the last one use the same size
+		if (!variableBlockSize && this->nominalBlockSize == 0 && number == 0)
+		{
+			this->nominalBlockSize = blockSize;
+		}
+		this->blockSample = (variableBlockSize ? number : number * (this->nominalBlockSize > 0 ? this->nominalBlockSize : blockSize));
+		this->blockSize = blockSize;
+		this->blockPosition = 0;
+		int* left = &this->samples[0];
+		int* right = &this->samples[this->blockCapacity];
+		int sideBits = 0;
+		for_iter (c, 0, channels)
+		{
+			// the side channel requires one additional bit
+			sideBits = ((channelAssignment == FLAC_CHANNELS_SIDE_RIGHT && c == 0) ||
+				((channelAssignment == FLAC_CHANNELS_LEFT_SIDE || channelAssignment == FLAC_CHANNELS_MID_SIDE) && c == 1) ? 1 : 0);
+			if (!this->_decodeSubframe(&this->samples[c * this->blockCapacity], blockSize, bitsPerSample + sideBits))
+			{
+				// the next call continues with the search for the next frame's sync code
+				hlog::warn(logTag, "FLAC: invalid subframe, muting frame: " + this->filename);
+				this->_muteFrame();
+				return true;
+			}
+		}
+		this->_alignToByte();
+		crc = this->crc16;
+		if (this->_readBits(16) != crc)
+		{
+			hlog::warn(logTag, "FLAC: frame CRC mismatch, muting frame: " + this->filename);
+			this->_muteFrame();
+			return true;
+		}
+		if (channelAssignment == FLAC_CHANNELS_LEFT_SIDE)
+		{
+			for_iter (i, 0, blockSize)
+			{
+				right[i] = left[i] - right[i];
+			}
+		}
+		else if (channelAssignment == FLAC_CHANNELS_SIDE_RIGHT)
+		{
+			for_iter (i, 0, blockSize)
+			{
+				left[i] += right[i];
+			}
+		}
+		else if (channelAssignment == FLAC_CHANNELS_MID_SIDE)
+		{
+			int mid = 0;
+			int side = 0;
+			for_iter (i, 0, blockSize)
+			{
+				side = right[i];
+				mid = (left[i] << 1) | (side & 0x1);
+				left[i] = (mid + side) >> 1;
+				right[i] = (mid - side) >> 1;
+			}
+		}
+		return true;
+	}
+
+	void FLAC_Source::_muteFrame()
+	{
+		// corrupted frames are replaced with silence so the sound keeps its length
+		for_iter (c, 0, this->channels)
+		{
+			memset(&this->samples[c * this->blockCapacity], 0, this->blockSize * sizeof(int));
+		}
+	}
+
+	bool FLAC_Source::_decodeSubframe(int* output, int blockSize, int bitsPerSample)
+	{
+		this->_readBits(1); // padding
+		int type = this->_readBits(6);
+		int wastedBits = 0;
+		if (this->_readBits(1) != 0)
+		{
+			wastedBits = this->_readUnary() + 1;
+			bitsPerSample -= wastedBits;
+		}
+		if (type == 0) // constant
+		{
+			int value = this->_readSignedBits(bitsPerSample);
+			for_iter (i, 0, blockSize)
+			{
+				output[i] = value;
+			}
+		}
+		else if (type == 1) // verbatim
+		{
+			for_iter (i, 0, blockSize)
+			{
+				output[i] = this->_readSignedBits(bitsPerSample);
+			}
+		}
+		else if (type >= 8 && type <= 12) // fixed predictor
+		{
+			int order = type - 8;
+			if (order > blockSize)
+			{
+				return false;
+			}
+			for_iter (i, 0, order)
+			{
+				output[i] = this->_readSignedBits(bitsPerSample);
+			}
+			if (!this->_decodeResidual(output, blockSize, order))
+			{
+				return false;
+			}
+			switch (order)
+			{
+			case 1:
+				for_iter (i, 1, blockSize)
+				{
+					output[i] += output[i - 1];
+				}
+				break;
+			case 2:
+				for_iter (i, 2, blockSize)
+				{
+					output[i] += 2 * output[i - 1] - output[i - 2];
+				}
+				break;
+			case 3:
+				for_iter (i, 3, blockSize)
+				{
+					output[i] += 3 * output[i - 1] - 3 * output[i - 2] + output[i - 3];
+				}
+				break;
+			case 4:
+				for_iter (i, 4, blockSize)
+				{
+					output[i] += 4 * output[i - 1] - 6 * output[i - 2] + 4 * output[i - 3] - output[i - 4];
+				}
+				break;
+			}
+		}
+		else if (type >= 32) // linear prediction
+		{
+			int order = type - 31;
+			if (order > blockSize)
+			{
+				return false;
+			}
+			for_iter (i, 0, order)
+			{
+				output[i] = this->_readSignedBits(bitsPerSample);
+			}
+			int precision = this->_readBits(4) + 1;
+			int shift = this->_readSignedBits(5);
+			if (precision > 15 || shift < 0)
+			{
+				return false;
+			}
+			int coefficients[32] = {0};
+			for_iter (i, 0, order)
+			{
+				coefficients[i] = this->_readSignedBits(precision);
+			}
+			if (!this->_decodeResidual(output, blockSize, order))
+			{
+				return false;
+			}
+			if (bitsPerSample + precision + _getBitLength(order) <= 32) // the sum can't overflow
+			{
+				int sum = 0;
+				for_iter (i, order, blockSize)
+				{
+					sum = 0;
+					for_iter (j, 0, order)
+					{
+						sum += coefficients[j] * output[i - 1 - j];
+					}
+					output[i] += (sum >> shift);
+				}
+			}
+			else
+			{
+				int64_t sum = 0;
+				for_iter (i, order, blockSize)
+				{
+					sum = 0;
+					for_iter (j, 0, order)
+					{
+						sum += (int64_t)coefficients[j] * output[i - 1 - j];
+					}
+					output[i] += (int)(sum >> shift);
+				}
+			}
+		}
+		else // reserved
+		{
+			return false;
+		}
+		if (wastedBits > 0)
+		{
+			for_iter (i, 0, blockSize)
+			{
+				output[i] <<= wastedBits;
+			}
+		}
+		return true;
+	}
+
+	bool FLAC_Source::_decodeResidual(int* output, int blockSize, int order)
+	{
+		int method = this->_readBits(2);
+		if (method > 1)
+		{
+			return false;
+		}
+		int parameterBits = (method == 0 ? 4 : 5);
+		unsigned int escapeCode = (method == 0 ? 0xF : 0x1F);
+		int partitionOrder = this->_readBits(4);
+		int partitions = (1 << partitionOrder);
+		int index = order;
+		int count = 0;
+		unsigned int parameter = 0;
+		unsigned int value = 0;
+		int bits = 0;
+		for_iter (p, 0, partitions)
+		{
+			count = (blockSize >> partitionOrder) - (p == 0 ? order : 0);
+			if (count < 0 || index + count > blockSize)
+			{
+				return false;
+			}
+			parameter = this->_readBits(parameterBits);
+			if (parameter == escapeCode) // unencoded residual
+			{
+				bits = this->_readBits(5);
+				for_iter (i, 0, count)
+				{
+					output[index++] = this->_readSignedBits(bits);
+				}
+			}
+			else // rice coded residual
+			{
+				for_iter (i, 0, count)
+				{
+					value = (this->_readUnary() << parameter) | this->_readBits(parameter);
+					output[index++] = (int)(value >> 1) ^ -(int)(value & 0x1);
+				}
+			}
+		}
+		return true;
+	}
+
+	void FLAC_Source::_resetReader()
+	{
+		this->readSize = 0;
+		this->readPosition = 0;
+		this->bitCache = 0;
+		this->bitCount = 0;
+		this->crc8 = 0;
+		this->crc16 = 0;
+	}
+
+	bool FLAC_Source::_createCrcTables()
+	{
+		// CRC-8 with polynomial x^8 + x^2 + x + 1 and CRC-16 with polynomial x^16 + x^15 + x^2 + 1, both unreflected
+		unsigned int crc = 0;
+		for_iter (i, 0, 256)
+		{
+			crc = i;
+			for_iter (j, 0, 8)
+			{
+				crc = ((crc & 0x80) != 0 ? (crc << 1) ^ 0x07 : crc << 1);
+			}
+			crc8Table[i] = (unsigned char)crc;
+			crc = i << 8;
+			for_iter (j, 0, 8)
+			{
+				crc = ((crc & 0x8000) != 0 ? (crc << 1) ^ 0x8005 : crc << 1);
+			}
+			crc16Table[i] = (unsigned short)crc;
+		}
+		return true;
 	}
 
 }
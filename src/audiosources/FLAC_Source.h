@@ -14,6 +14,9 @@
 #ifndef XAL_FLAC_SOURCE_H
 #define XAL_FLAC_SOURCE_H
 
+#define FLAC_READ_BUFFER_SIZE 16384
+
+#include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
 #include "Source.h"
@@ -30,9 +33,115 @@ namespace xal
 		bool open() override;
 		void close() override;
 		void rewind() override;
+		bool seek(int64_t sample) override;
 		bool load(hstream& output) override;
 		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
 
+	protected:
+		int dataBitsPerSample;
+		int64_t totalSamples;
+		int64_t firstFramePosition;
+		harray<int64_t> seekPointSamples;
+		harray<int64_t> seekPointOffsets;
+		harray<int> samples;
+		int blockCapacity;
+		int nominalBlockSize;
+		int blockSize;
+		int blockPosition;
+		int64_t blockSample;
+		unsigned char* readBuffer;
+		int readSize;
+		int readPosition;
+		uint64_t bitCache;
+		int bitCount;
+		unsigned int crc8;
+		unsigned int crc16;
+
+		static unsigned char crc8Table[256];
+		static unsigned short crc16Table[256];
+		static bool crcTablesCreated;
+
+		int _read(char* output, int size);
+		void _writeFrames(char* output, int offset, int count);
+		bool _decodeFrame();
+		bool _decodeSubframe(int* output, int blockSize, int bitsPerSample);
+		bool _decodeResidual(int* output, int blockSize, int order);
+		void _muteFrame();
+		void _resetReader();
+
+		static bool _createCrcTables();
+
+		inline unsigned int _readByte()
+		{
+			if (this->readPosition >= this->readSize)
+			{
+				this->readSize = hmax(this->stream->readRaw(this->readBuffer, FLAC_READ_BUFFER_SIZE), 0);
+				this->readPosition = 0;
+				if (this->readSize == 0)
+				{
+					return 0;
+				}
+			}
+			unsigned int value = this->readBuffer[this->readPosition++];
+			// every byte of a frame is covered by the checksums
+			this->crc8 = crc8Table[this->crc8 ^ value];
+			this->crc16 = ((this->crc16 << 8) ^ crc16Table[(this->crc16 >> 8) ^ value]) & 0xFFFF;
+			return value;
+		}
+
+		inline unsigned int _readBits(int count) // up to 32 bits
+		{
+			while (this->bitCount < count)
+			{
+				this->bitCache = (this->bitCache << 8) | this->_readByte();
+				this->bitCount += 8;
+			}
+			this->bitCount -= count;
+			return (unsigned int)((this->bitCache >> this->bitCount) & ((1ULL << count) - 1));
+		}
+
+		inline int _readSignedBits(int count)
+		{
+			if (count == 0)
+			{
+				return 0;
+			}
+			return ((int)(this->_readBits(count) << (32 - count)) >> (32 - count));
+		}
+
+		inline unsigned int _readUnary()
+		{
+			unsigned int result = 0;
+			while (true)
+			{
+				if (this->bitCount == 0)
+				{
+					if (this->_isEndOfData()) // corrupted data
+					{
+						return result;
+					}
+					this->bitCache = this->_readByte();
+					this->bitCount = 8;
+				}
+				--this->bitCount;
+				if (((this->bitCache >> this->bitCount) & 1) != 0)
+				{
+					return result;
+				}
+				++result;
+			}
+		}
+
+		inline void _alignToByte()
+		{
+			this->bitCount -= this->bitCount % 8;
+		}
+
+		inline bool _isEndOfData() const
+		{
+			return (this->bitCount < 8 && this->readPosition >= this->readSize && this->stream->eof());
+		}
+
 	};
 
 }
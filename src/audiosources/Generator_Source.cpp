@@ -0,0 +1,90 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
+#include "Generator_Source.h"
+#include "xal.h"
+
+namespace xal
+{
+	Generator_Source::Generator_Source(GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample) :
+		Source("", SourceMode::Ram, BufferMode::Streamed),
+		position(0)
+	{
+		this->callback = callback;
+		this->userData = userData;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = bitsPerSample;
+	}
+
+	Generator_Source::~Generator_Source()
+	{
+		this->close();
+	}
+
+	bool Generator_Source::open()
+	{
+		// there is no file, the callback provides all data
+		this->streamOpen = (this->callback != NULL);
+		this->position = 0;
+		return this->streamOpen;
+	}
+
+	void Generator_Source::close()
+	{
+		this->streamOpen = false;
+	}
+
+	void Generator_Source::rewind()
+	{
+		this->position = 0;
+	}
+
+	bool Generator_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		// the callback gets the new position with the next request
+		this->position = sample * this->channels * this->bitsPerSample / 8;
+		return true;
+	}
+
+	bool Generator_Source::load(hstream& output)
+	{
+		hlog::error(logTag, "Generated audio can only be streamed!");
+		return false;
+	}
+
+	int Generator_Source::loadChunk(hstream& output, int size)
+	{
+		if (Source::loadChunk(output, size) == 0)
+		{
+			return 0;
+		}
+		// the data is generated directly into the Buffer's stream without a decode buffer, audio-systems still copy it into their own buffers from there
+		int frameSize = this->channels * this->bitsPerSample / 8;
+		size = size / frameSize * frameSize;
+		output.prepareManualWriteRaw(size);
+		int written = (*this->callback)(&output[(int)output.position()], size, this->position, this->userData);
+		written = hclamp(written, 0, size) / frameSize * frameSize;
+		this->position += written;
+		if (written < size)
+		{
+			output.truncate(output.position() + (int64_t)written);
+		}
+		return written;
+	}
+
+}
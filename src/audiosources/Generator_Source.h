@@ -0,0 +1,50 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides a source for audio data that is generated by a callback.
+
+#ifndef XAL_GENERATOR_SOURCE_H
+#define XAL_GENERATOR_SOURCE_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
+#include "Source.h"
+#include "xalExport.h"
+
+namespace xal
+{
+	class xalExport Generator_Source : public Source
+	{
+	public:
+		Generator_Source(GeneratorCallback callback, void* userData, int channels, int samplingRate, int bitsPerSample);
+		~Generator_Source();
+
+		HL_DEFINE_GET(GeneratorCallback, callback, Callback);
+		HL_DEFINE_GET(void*, userData, UserData);
+
+		bool open() override;
+		void close() override;
+		void rewind() override;
+		bool seek(int64_t sample) override;
+		bool load(hstream& output) override;
+		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
+
+	protected:
+		GeneratorCallback callback;
+		void* userData;
+		int64_t position;
+
+	};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
+#include "Memory_Source.h"
+#include "xal.h"
+
+namespace xal
+{
+	Memory_Source::Memory_Source(unsigned char* data, int64_t dataSize, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData) :
+		Source("", SourceMode::Ram, BufferMode::Streamed),
+		position(0)
+	{
+		this->data = data;
+		this->dataSize = dataSize;
+		this->releaseCallback = releaseCallback;
+		this->userData = userData;
+		this->channels = channels;
+		this->samplingRate = samplingRate;
+		this->bitsPerSample = bitsPerSample;
+		this->size = dataSize;
+		this->duration = (float)dataSize / (samplingRate * channels * bitsPerSample / 8);
+	}
+
+	Memory_Source::~Memory_Source()
+	{
+		this->close();
+		// only the source of the Sound itself has a release callback, the ones of Players just reference the same data
+		if (this->releaseCallback != NULL)
+		{
+			(*this->releaseCallback)(this->data, this->userData);
+		}
+	}
+
+	bool Memory_Source::open()
+	{
+		// there is no file, the data is read directly from the application's memory
+		this->streamOpen = (this->data != NULL);
+		this->position = 0;
+		return this->streamOpen;
+	}
+
+	void Memory_Source::close()
+	{
+		this->streamOpen = false;
+	}
+
+	void Memory_Source::rewind()
+	{
+		this->position = 0;
+	}
+
+	bool Memory_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		this->position = hclamp(sample * this->channels * this->bitsPerSample / 8, (int64_t)0, this->dataSize);
+		return true;
+	}
+
+	bool Memory_Source::load(hstream& output)
+	{
+		if (!Source::load(output))
+		{
+			return false;
+		}
+		output.writeRaw(this->data, (int)this->dataSize);
+		return true;
+	}
+
+	int Memory_Source::loadChunk(hstream& output, int size)
+	{
+		if (Source::loadChunk(output, size) == 0)
+		{
+			return 0;
+		}
+		int frameSize = this->channels * this->bitsPerSample / 8;
+		int read = (int)hclamp(this->dataSize - this->position, (int64_t)0, (int64_t)size) / frameSize * frameSize;
+		if (read > 0)
+		{
+			// only the current chunk is copied into the memory that is handed to the audio-system
+			output.prepareManualWriteRaw(read);
+			memcpy(&output[(int)output.position()], &this->data[this->position], read);
+			this->position += read;
+		}
+		return read;
+	}
+
+}
@@ -0,0 +1,52 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides a source for PCM data in memory that is owned by the application.
+
+#ifndef XAL_MEMORY_SOURCE_H
+#define XAL_MEMORY_SOURCE_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "AudioManager.h"
+#include "Source.h"
+#include "xalExport.h"
+
+namespace xal
+{
+	class xalExport Memory_Source : public Source
+	{
+	public:
+		Memory_Source(unsigned char* data, int64_t dataSize, int channels, int samplingRate, int bitsPerSample, ReleaseCallback releaseCallback, void* userData);
+		~Memory_Source();
+
+		HL_DEFINE_GET(unsigned char*, data, Data);
+		HL_DEFINE_GET(int64_t, dataSize, DataSize);
+
+		bool open() override;
+		void close() override;
+		void rewind() override;
+		bool seek(int64_t sample) override;
+		bool load(hstream& output) override;
+		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
+
+	protected:
+		unsigned char* data;
+		int64_t dataSize;
+		ReleaseCallback releaseCallback;
+		void* userData;
+		int64_t position;
+
+	};
+
+}
+
+#endif
@@ -7,25 +7,47 @@
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
 #ifdef _FORMAT_OGG
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <ogg/ogg.h>
+#ifndef _OGG_TREMOR
 #include <vorbis/codec.h>
 #include <vorbis/vorbisfile.h>
+#else
+#include <ivorbiscodec.h>
+#include <ivorbisfile.h>
+#endif
 
+#include <hltypes/harray.h>
+#include <hltypes/hdir.h>
+#include <hltypes/hexception.h>
+#include <hltypes/hfile.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hltypesUtil.h>
-#include <hltypes/hresource.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
+#include <hltypes/hthread.h>
 
 #include "AudioManager.h"
+#include "BufferAsync.h"
+#include "MappedStream.h"
 #include "OGG_Source.h"
+#include "ProviderStream.h"
+#include "Utility.h"
 #include "xal.h"
 
+#define OGG_SEGMENT_MIN_DURATION 30.0f // files are only split into segments that are at least this long
+#define OGG_DECODER_CACHE_SIZE 16 // how many idle decoders are kept for reuse
+#define OGG_SEEK_INDEX_EXTENSION ".xalidx"
+#define OGG_SEEK_INDEX_VERSION 1
+#define OGG_SEEK_INDEX_DISTANCE 16384 // minimum byte distance between seek points, keeps the index small while decoding little after a seek
+#define OGG_PAGE_HEADER_SIZE 27
+#define OGG_ID_HEADER_SIZE 16
+#define OGG_MAX_PAGE_SIZE 65307 // header, 255 segment sizes and 255 segments with 255 bytes each
+
 namespace xal
 {
-	// small optimization, it's not thread-safe, but since it's not used anywhere, it doesn't matter
-	static int _section = 0;
-
 	static size_t _dataRead(void* data, size_t size, size_t count, void* dataSource)
 	{
 		hsbase* stream = (hsbase*)dataSource;
@@ -47,7 +69,7 @@ namespace xal
 			mode = hseek::End;
 			break;
 		}
-		((hsbase*)dataSource)->seek((long)offset, mode);
+		((hsbase*)dataSource)->seek((int64_t)offset, mode);
 		return 0;
 	}
 
@@ -56,13 +78,420 @@ namespace xal
 		return 0;
 	}
 
+	// the decoder's API returns long here which is only 32 bit on Windows, an error is reported instead of a position that wrapped around
+	static long _toTellResult(int64_t position)
+	{
+		if (position > (int64_t)LONG_MAX)
+		{
+			return -1;
+		}
+		return (long)position;
+	}
+
 	static long _dataTell(void* dataSource)
 	{
-		return (long)((hsbase*)dataSource)->position();
+		return _toTellResult(((hsbase*)dataSource)->position());
+	}
+
+	// used by segment decoders which all read the same compressed data, but each with its own position
+	struct MemoryDataSource
+	{
+		const unsigned char* data;
+		int64_t size;
+		int64_t position;
+	};
+
+	static size_t _memoryRead(void* data, size_t size, size_t count, void* dataSource)
+	{
+		MemoryDataSource* source = (MemoryDataSource*)dataSource;
+		int64_t bytes = hmin((int64_t)(size * count), source->size - source->position);
+		if (bytes <= 0)
+		{
+			return 0;
+		}
+		memcpy(data, &source->data[source->position], (size_t)bytes);
+		source->position += bytes;
+		return (size_t)bytes;
+	}
+
+	static int _memorySeek(void* dataSource, ogg_int64_t offset, int whence)
+	{
+		MemoryDataSource* source = (MemoryDataSource*)dataSource;
+		int64_t position = offset;
+		if (whence == SEEK_CUR)
+		{
+			position += source->position;
+		}
+		else if (whence == SEEK_END)
+		{
+			position += source->size;
+		}
+		if (position < 0 || position > source->size)
+		{
+			return -1;
+		}
+		source->position = position;
+		return 0;
+	}
+
+	static long _memoryTell(void* dataSource)
+	{
+		return _toTellResult(((MemoryDataSource*)dataSource)->position);
+	}
+
+	static int _readPcm(OggVorbis_File* oggStream, char* output, int size, int channels, int bitsPerSample)
+	{
+		int section = 0;
+#ifdef _OGG_TREMOR
+		return (int)ov_read(oggStream, output, size, &section);
+#else
+		if (bitsPerSample != FLOAT_BITS_PER_SAMPLE)
+		{
+			return (int)ov_read(oggStream, output, size, 0, 2, 1, &section);
+		}
+		float** pcm = NULL;
+		int frameSize = channels * sizeof(float);
+		int frames = (int)ov_read_float(oggStream, &pcm, size / frameSize, &section);
+		if (frames <= 0)
+		{
+			return 0;
+		}
+		// vorbis decodes into separate channel buffers so the data only has to be interleaved
+		float* data = (float*)output;
+		float* channel = NULL;
+		for_iter (c, 0, channels)
+		{
+			channel = pcm[c];
+			for_iter (i, 0, frames)
+			{
+				data[i * channels + c] = channel[i];
+			}
+		}
+		return (frames * frameSize);
+#endif
+	}
+
+	// a range of samples of a large file that is decoded independently of the others
+	struct DecodeSegment
+	{
+		MemoryDataSource dataSource;
+		int64_t start;
+		int64_t end;
+		int channels;
+		int bitsPerSample;
+		char* output;
+		bool succeeded;
+	};
+
+	// the segments of one file that are shared by the threads decoding it
+	struct DecodeSegmentQueue
+	{
+		harray<DecodeSegment*> segments;
+		hmutex mutex;
+	};
+
+	static void _decodeSegments(hthread* thread);
+
+	class SegmentDecoderThread : public hthread
+	{
+	public:
+		SegmentDecoderThread(DecodeSegmentQueue* queue) : hthread(&_decodeSegments, "XAL OGG segment decoder"), queue(queue)
+		{
+		}
+
+		DecodeSegmentQueue* queue;
+
+	};
+
+	// segment decoders of all loads together must not use more threads than there are CPUs
+	static int segmentDecoderCount = 0;
+	static hmutex segmentDecoderMutex;
+
+	static void _decodeSegment(DecodeSegment* segment)
+	{
+		ov_callbacks callbacks;
+		callbacks.read_func = &_memoryRead;
+		callbacks.seek_func = &_memorySeek;
+		callbacks.close_func = &_dataClose;
+		callbacks.tell_func = &_memoryTell;
+		OggVorbis_File oggStream;
+		int remaining = (int)((segment->end - segment->start) * segment->channels * segment->bitsPerSample / 8);
+		char* buffer = segment->output;
+		int read = 0;
+		if (ov_open_callbacks((void*)&segment->dataSource, &oggStream, NULL, 0, callbacks) == 0)
+		{
+			// seeking is sample-accurate so segments line up seamlessly
+			if (ov_pcm_seek(&oggStream, segment->start) == 0)
+			{
+				while (remaining > 0)
+				{
+					read = _readPcm(&oggStream, buffer, remaining, segment->channels, segment->bitsPerSample);
+					if (read <= 0)
+					{
+						break;
+					}
+					remaining -= read;
+					buffer += read;
+				}
+			}
+			ov_clear(&oggStream);
+		}
+		segment->succeeded = (remaining == 0);
+	}
+
+	static void _decodeQueuedSegments(DecodeSegmentQueue* queue)
+	{
+		DecodeSegment* segment = NULL;
+		hmutex::ScopeLock lock(&queue->mutex);
+		while (queue->segments.size() > 0)
+		{
+			segment = queue->segments.removeFirst();
+			lock.release();
+			_decodeSegment(segment);
+			lock.acquire(&queue->mutex);
+		}
+	}
+
+	static void _decodeSegments(hthread* thread)
+	{
+		_decodeQueuedSegments(((SegmentDecoderThread*)thread)->queue);
+	}
+
+	// an idle decoder with parsed headers and codebooks that can be reused for the same file
+	struct CachedDecoder
+	{
+		hstr filename;
+		int64_t dataSize;
+		int64_t modificationTime;
+		OggVorbis_File* oggStream;
+	};
+
+	static harray<CachedDecoder> cachedDecoders;
+	static hmutex cachedDecodersMutex;
+
+	static OggVorbis_File* _takeCachedDecoder(chstr filename, int64_t modificationTime, hsbase* stream)
+	{
+		hmutex::ScopeLock lock(&cachedDecodersMutex);
+		int64_t dataSize = stream->size();
+		for_iter (i, 0, cachedDecoders.size())
+		{
+			// a replaced file can have the same size so its decoder state would be stale
+			if (cachedDecoders[i].filename == filename && cachedDecoders[i].dataSize == dataSize && cachedDecoders[i].modificationTime == modificationTime)
+			{
+				OggVorbis_File* result = cachedDecoders[i].oggStream;
+				cachedDecoders.removeAt(i);
+				// the decoder only keeps byte offsets of the data so it can continue on a new stream of the same file
+				result->datasource = (void*)stream;
+				return result;
+			}
+		}
+		return NULL;
+	}
+
+	static void _cacheDecoder(chstr filename, int64_t dataSize, int64_t modificationTime, OggVorbis_File* oggStream)
+	{
+		hmutex::ScopeLock lock(&cachedDecodersMutex);
+		CachedDecoder decoder;
+		decoder.filename = filename;
+		decoder.dataSize = dataSize;
+		decoder.modificationTime = modificationTime;
+		decoder.oggStream = oggStream;
+		decoder.oggStream->datasource = NULL; // the stream may be deleted while the decoder is idle
+		cachedDecoders += decoder;
+		while (cachedDecoders.size() > OGG_DECODER_CACHE_SIZE)
+		{
+			ov_clear(cachedDecoders.first().oggStream);
+			delete cachedDecoders.first().oggStream;
+			cachedDecoders.removeFirst();
+		}
+	}
+
+	static hstr _getSeekIndexFilename(chstr filename)
+	{
+		hstr path = xal::manager->getSeekIndexPath();
+		if (path == "")
+		{
+			return (filename + OGG_SEEK_INDEX_EXTENSION);
+		}
+		return hdir::joinPath(path, filename + OGG_SEEK_INDEX_EXTENSION);
+	}
+
+	// collects the starting byte offset of a page every few KB together with the sample position where decoding continues from there
+	static bool _scanPages(hsbase* stream, harray<int64_t>& samples, harray<int64_t>& offsets)
+	{
+		samples.clear();
+		offsets.clear();
+		unsigned char header[OGG_PAGE_HEADER_SIZE];
+		unsigned char segments[255];
+		int64_t granule = 0;
+		int64_t lastGranule = 0;
+		int64_t offset = 0;
+		int64_t lastOffset = -OGG_SEEK_INDEX_DISTANCE;
+		unsigned int serial = 0;
+		unsigned int firstSerial = 0;
+		int bodySize = 0;
+		stream->rewind();
+		while (stream->readRaw(header, OGG_PAGE_HEADER_SIZE) == OGG_PAGE_HEADER_SIZE)
+		{
+			if (memcmp(header, "OggS", 4) != 0)
+			{
+				return false;
+			}
+			memcpy(&serial, &header[14], 4);
+			if (offset == 0)
+			{
+				firstSerial = serial;
+			}
+			else if (serial != firstSerial) // chained files have more than one logical stream
+			{
+				return false;
+			}
+			if (stream->readRaw(segments, header[26]) != header[26])
+			{
+				return false;
+			}
+			bodySize = 0;
+			for_iter (i, 0, header[26])
+			{
+				bodySize += segments[i];
+			}
+			if (offset - lastOffset >= OGG_SEEK_INDEX_DISTANCE)
+			{
+				samples += lastGranule;
+				offsets += offset;
+				lastOffset = offset;
+			}
+			memcpy(&granule, &header[6], 8);
+			if (granule >= 0) // -1 means that no packet is finished on this page
+			{
+				lastGranule = granule;
+			}
+			stream->seek(bodySize);
+			offset += OGG_PAGE_HEADER_SIZE + header[26] + bodySize;
+		}
+		return (offsets.size() > 0);
+	}
+
+	// reads the format from the identification header and the length from the granule position of the last page
+	static bool _probeHeaders(hsbase* stream, int& channels, int& samplingRate, int64_t& samples)
+	{
+		unsigned char header[OGG_PAGE_HEADER_SIZE];
+		unsigned char packet[OGG_ID_HEADER_SIZE];
+		stream->rewind();
+		if (stream->readRaw(header, OGG_PAGE_HEADER_SIZE) != OGG_PAGE_HEADER_SIZE || memcmp(header, "OggS", 4) != 0)
+		{
+			return false;
+		}
+		unsigned int serial = 0;
+		memcpy(&serial, &header[14], 4);
+		stream->seek(header[26]);
+		if (stream->readRaw(packet, OGG_ID_HEADER_SIZE) != OGG_ID_HEADER_SIZE || packet[0] != 1 || memcmp(&packet[1], "vorbis", 6) != 0)
+		{
+			return false;
+		}
+		channels = packet[11];
+		memcpy(&samplingRate, &packet[12], 4);
+		int64_t size = stream->size();
+		int tailSize = (int)hmin(size, (int64_t)OGG_MAX_PAGE_SIZE);
+		unsigned char* tail = new unsigned char[tailSize];
+		stream->seek(size - tailSize, hseek::Start);
+		int read = stream->readRaw(tail, tailSize);
+		unsigned int pageSerial = 0;
+		int64_t granule = -1;
+		samples = -1;
+		for (int i = read - OGG_PAGE_HEADER_SIZE; i >= 0; --i)
+		{
+			if (memcmp(&tail[i], "OggS", 4) == 0 && tail[i + 4] == 0)
+			{
+				memcpy(&pageSerial, &tail[i + 14], 4);
+				if (pageSerial != serial) // chained files have more than one logical stream, only the decoder knows their length
+				{
+					break;
+				}
+				memcpy(&granule, &tail[i + 6], 8);
+				if (granule >= 0) // -1 means that no packet is finished on this page
+				{
+					samples = granule;
+					break;
+				}
+			}
+		}
+		delete[] tail;
+		return (channels > 0 && samplingRate > 0 && samples >= 0);
+	}
+
+	static bool _readSeekIndex(hsbase& stream, int64_t dataSize, harray<int64_t>& samples, harray<int64_t>& offsets)
+	{
+		unsigned char header[20];
+		if (stream.readRaw(header, 20) != 20 || memcmp(header, "XIDX", 4) != 0)
+		{
+			return false;
+		}
+		int version = 0;
+		int64_t indexDataSize = 0;
+		int count = 0;
+		memcpy(&version, &header[4], 4);
+		memcpy(&indexDataSize, &header[8], 8);
+		memcpy(&count, &header[16], 4);
+		// the audio file was changed since the index was created
+		if (version != OGG_SEEK_INDEX_VERSION || indexDataSize != dataSize || count <= 0)
+		{
+			return false;
+		}
+		samples.clear();
+		offsets.clear();
+		int64_t values[2];
+		for_iter (i, 0, count)
+		{
+			if (stream.readRaw(values, (int)sizeof(values)) != (int)sizeof(values))
+			{
+				return false;
+			}
+			samples += values[0];
+			offsets += values[1];
+		}
+		return true;
+	}
+
+	static bool _writeSeekIndex(chstr filename, int64_t dataSize, const harray<int64_t>& samples, const harray<int64_t>& offsets)
+	{
+		hstream data;
+		unsigned char header[20];
+		int version = OGG_SEEK_INDEX_VERSION;
+		int count = samples.size();
+		memcpy(header, "XIDX", 4);
+		memcpy(&header[4], &version, 4);
+		memcpy(&header[8], &dataSize, 8);
+		memcpy(&header[16], &count, 4);
+		data.writeRaw(header, 20);
+		int64_t values[2];
+		for_iter (i, 0, count)
+		{
+			values[0] = samples[i];
+			values[1] = offsets[i];
+			data.writeRaw((unsigned char*)values, sizeof(values));
+		}
+		data.rewind();
+		try
+		{
+			hdir::create(hdir::baseDir(filename));
+			hfile file;
+			file.open(filename, hfaccess::Write);
+			file.writeRaw(data);
+			file.close();
+		}
+		catch (hexception& e) // assets may be located in read-only locations so this is not an error
+		{
+			hlog::warn(logTag, "Could not write OGG seek index: " + e.getMessage());
+			return false;
+		}
+		return true;
 	}
 
 	OGG_Source::OGG_Source(chstr filename, SourceMode sourceMode, BufferMode bufferMode) :
-		Source(filename, sourceMode, bufferMode)
+		Source(filename, sourceMode, bufferMode),
+		oggStream(NULL),
+		seekIndexPending(false)
 	{
 	}
 
@@ -78,22 +507,37 @@ namespace xal
 		{
 			return false;
 		}
-		// setting the special callbacks
-		ov_callbacks callbacks;
-		callbacks.read_func = &_dataRead;
-		callbacks.seek_func = &_dataSeek;
-		callbacks.close_func = &_dataClose; // may not be NULL because it may crash on Android otherwise
-		callbacks.tell_func = &_dataTell;
-		if (ov_open_callbacks((void*)this->stream, &this->oggStream, NULL, 0, callbacks) == 0)
+		// parsing the headers and setting up the codebooks is expensive so a decoder of this file that was closed earlier is preferred
+		this->oggStream = _takeCachedDecoder(this->filename, this->modificationTime, this->stream);
+		if (this->oggStream == NULL)
+		{
+			// setting the special callbacks
+			ov_callbacks callbacks;
+			callbacks.read_func = &_dataRead;
+			callbacks.seek_func = &_dataSeek;
+			callbacks.close_func = &_dataClose; // may not be NULL because it may crash on Android otherwise
+			callbacks.tell_func = &_dataTell;
+			this->oggStream = new OggVorbis_File();
+			if (ov_open_callbacks((void*)this->stream, this->oggStream, NULL, 0, callbacks) != 0)
+			{
+				delete this->oggStream; // the decoder cleans up after itself when opening fails
+				this->oggStream = NULL;
+			}
+		}
+		if (this->oggStream != NULL)
 		{
-			vorbis_info* info = ov_info(&this->oggStream, -1);
+			vorbis_info* info = ov_info(this->oggStream, -1);
 			this->channels = (int)info->channels;
 			this->samplingRate = (int)info->rate;
-			this->bitsPerSample = 16; // always 16 bit data
-			int logicalSamples = (int)ov_pcm_total(&this->oggStream, -1);
+			this->_updateBitsPerSample();
+			int64_t logicalSamples = (int64_t)ov_pcm_total(this->oggStream, -1);
 			this->size = logicalSamples * this->channels * this->bitsPerSample / 8;
-			this->duration = (float)logicalSamples / this->samplingRate;
-			ov_pcm_seek(&this->oggStream, 0); // make sure the PCM stream is at the beginning to avoid nasty surprises
+			this->duration = (float)((double)logicalSamples / this->samplingRate);
+			if (this->bufferMode == BufferMode::Streamed && xal::manager->isSeekIndexEnabled())
+			{
+				this->_loadSeekIndex();
+			}
+			ov_pcm_seek(this->oggStream, 0); // make sure the PCM stream is at the beginning to avoid nasty surprises
 		}
 		else
 		{
@@ -103,36 +547,316 @@ namespace xal
 		return this->streamOpen;
 	}
 
+	bool OGG_Source::_probe()
+	{
+		Source::open();
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		// setting up a decoder parses all headers and codebooks which isn't needed for the metadata
+		int64_t logicalSamples = 0;
+		bool result = _probeHeaders(this->stream, this->channels, this->samplingRate, logicalSamples);
+		Source::close();
+		if (!result)
+		{
+			return Source::_probe();
+		}
+		this->_updateBitsPerSample();
+		this->size = logicalSamples * this->channels * this->bitsPerSample / 8;
+		this->duration = (float)((double)logicalSamples / this->samplingRate);
+		return true;
+	}
+
+	void OGG_Source::_updateBitsPerSample()
+	{
+#ifndef _OGG_TREMOR
+		// float data is passed on directly if the audio manager can use it, avoiding a quantization to 16 bit and back
+		int channels = this->channels;
+		int samplingRate = this->samplingRate;
+		this->bitsPerSample = FLOAT_BITS_PER_SAMPLE;
+		this->_getConvertedFormat(channels, samplingRate, this->bitsPerSample);
+		if (this->bitsPerSample != FLOAT_BITS_PER_SAMPLE)
+		{
+			this->bitsPerSample = 16;
+		}
+#else
+		this->bitsPerSample = 16; // the integer decoder always provides 16 bit data
+#endif
+	}
+
 	void OGG_Source::close()
 	{
-		if (this->streamOpen)
+		if (this->oggStream != NULL)
 		{
-			ov_clear(&this->oggStream);
+			_cacheDecoder(this->filename, this->stream->size(), this->modificationTime, this->oggStream);
+			this->oggStream = NULL;
 		}
+		this->seekPointSamples.clear();
+		this->seekPointOffsets.clear();
+		this->seekIndexPending = false;
 		Source::close();
 	}
 
+	bool OGG_Source::createSeekIndex(chstr filename)
+	{
+		hsbase* stream = ProviderStream::create(filename);
+		if (stream == NULL)
+		{
+			hlog::error(logTag, "File not found: " + filename);
+			return false;
+		}
+		harray<int64_t> samples;
+		harray<int64_t> offsets;
+		bool result = _scanPages(stream, samples, offsets);
+		int64_t dataSize = stream->size();
+		delete stream;
+		if (!result)
+		{
+			hlog::error(logTag, "Could not create OGG seek index: " + filename);
+			return false;
+		}
+		return _writeSeekIndex(_getSeekIndexFilename(filename), dataSize, samples, offsets);
+	}
+
+	void OGG_Source::clearDecoderCache()
+	{
+		hmutex::ScopeLock lock(&cachedDecodersMutex);
+		foreach (CachedDecoder, it, cachedDecoders)
+		{
+			ov_clear((*it).oggStream);
+			delete (*it).oggStream;
+		}
+		cachedDecoders.clear();
+	}
+
 	void OGG_Source::rewind()
 	{
 		if (this->streamOpen)
 		{
-			ov_pcm_seek(&this->oggStream, 0);
+			ov_pcm_seek(this->oggStream, 0);
 		}
 	}
 
+	bool OGG_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		if (this->seekIndexPending)
+		{
+			this->_createSeekIndex();
+		}
+		// with a seek index the page before the sample can be accessed directly instead of bisecting the file
+		int first = 0;
+		int last = this->seekPointSamples.size() - 1;
+		int index = -1;
+		int middle = 0;
+		while (first <= last)
+		{
+			middle = (first + last) / 2;
+			if (this->seekPointSamples[middle] <= sample)
+			{
+				index = middle;
+				first = middle + 1;
+			}
+			else
+			{
+				last = middle - 1;
+			}
+		}
+		if (index >= 0 && ov_raw_seek(this->oggStream, (ogg_int64_t)this->seekPointOffsets[index]) == 0)
+		{
+			int64_t position = (int64_t)ov_pcm_tell(this->oggStream);
+			if (position >= 0 && position <= sample && this->_skipSamples(sample - position))
+			{
+				return true;
+			}
+		}
+		return (ov_pcm_seek(this->oggStream, (ogg_int64_t)sample) == 0);
+	}
+
+	void OGG_Source::_loadSeekIndex()
+	{
+		int64_t dataSize = this->stream->size();
+		hstr path = xal::manager->getSeekIndexPath();
+		if (path != "")
+		{
+			hstr filename = _getSeekIndexFilename(this->filename);
+			if (hfile::exists(filename))
+			{
+				hfile file;
+				file.open(filename);
+				if (_readSeekIndex(file, dataSize, this->seekPointSamples, this->seekPointOffsets))
+				{
+					return;
+				}
+			}
+		}
+		// an index created offline is packed together with the audio file so it's accessed the same way
+		hsbase* stream = ProviderStream::create(this->filename + OGG_SEEK_INDEX_EXTENSION);
+		if (stream != NULL)
+		{
+			bool result = _readSeekIndex(*stream, dataSize, this->seekPointSamples, this->seekPointOffsets);
+			delete stream;
+			if (result)
+			{
+				return;
+			}
+		}
+		// scanning reads the whole file so it's postponed until the index is actually needed
+		this->seekPointSamples.clear();
+		this->seekPointOffsets.clear();
+		this->seekIndexPending = true;
+	}
+
+	void OGG_Source::_createSeekIndex()
+	{
+		this->seekIndexPending = false;
+		// the decoder repositions the stream on its next access so scanning can use it directly
+		if (!_scanPages(this->stream, this->seekPointSamples, this->seekPointOffsets))
+		{
+			this->seekPointSamples.clear();
+			this->seekPointOffsets.clear();
+			return;
+		}
+		// the directory of the audio files isn't necessarily writable so indices are only stored in the dedicated directory
+		if (xal::manager->getSeekIndexPath() != "")
+		{
+			_writeSeekIndex(_getSeekIndexFilename(this->filename), this->stream->size(), this->seekPointSamples, this->seekPointOffsets);
+		}
+	}
+
+	bool OGG_Source::_skipSamples(int64_t count)
+	{
+		unsigned char buffer[4096];
+		int frameSize = this->channels * this->bitsPerSample / 8;
+		int64_t remaining = count * frameSize;
+		int read = 0;
+		while (remaining > 0)
+		{
+			read = _readPcm(this->oggStream, (char*)buffer, (int)hmin(remaining, (int64_t)(sizeof(buffer) / frameSize * frameSize)), this->channels, this->bitsPerSample);
+			if (read <= 0)
+			{
+				return false;
+			}
+			remaining -= read;
+		}
+		return true;
+	}
+
+	bool OGG_Source::_loadSegments(char* output)
+	{
+		int count = hmin(BufferAsync::getCpuCount(), (int)(this->duration / OGG_SEGMENT_MIN_DURATION));
+		if (count < 2 || ov_streams(this->oggStream) != 1)
+		{
+			return false;
+		}
+		// this thread decodes one segment itself, only the additional threads are taken from the shared budget
+		hmutex::ScopeLock lock(&segmentDecoderMutex);
+		int threadCount = hmin(count - 1, BufferAsync::getCpuCount() - 1 - segmentDecoderCount);
+		if (threadCount < 1)
+		{
+			return false;
+		}
+		segmentDecoderCount += threadCount;
+		lock.release();
+		count = threadCount + 1;
+		// segment decoders need random access to the compressed data without interfering with each other, data that is already in memory is used directly
+		const unsigned char* data = NULL;
+		int64_t dataSize = this->stream->size();
+		hstream* memoryStream = dynamic_cast<hstream*>(this->stream);
+		MappedStream* mappedStream = dynamic_cast<MappedStream*>(this->stream);
+		ProviderStream* providerStream = dynamic_cast<ProviderStream*>(this->stream);
+		if (memoryStream != NULL)
+		{
+			data = (const unsigned char*)&(*memoryStream)[0];
+		}
+		else if (mappedStream != NULL)
+		{
+			data = mappedStream->getData();
+		}
+		else if (providerStream != NULL)
+		{
+			data = providerStream->getData();
+		}
+		hstream fileData;
+		if (data == NULL)
+		{
+			// only a plain file (e.g. from a bank or an IoProvider without mapping) has to be copied
+			int64_t position = this->stream->position();
+			this->stream->rewind();
+			fileData.writeRaw(*this->stream);
+			this->stream->seek(position, hseek::Start);
+			data = (const unsigned char*)&fileData[0];
+			dataSize = fileData.size();
+		}
+		int64_t samples = ov_pcm_total(this->oggStream, -1);
+		int frameSize = this->channels * this->bitsPerSample / 8;
+		harray<DecodeSegment*> ownSegments;
+		DecodeSegment* segment = NULL;
+		for_iter (i, 0, count)
+		{
+			segment = new DecodeSegment();
+			segment->dataSource.data = data;
+			segment->dataSource.size = dataSize;
+			segment->dataSource.position = 0;
+			segment->start = samples * i / count;
+			segment->end = samples * (i + 1) / count;
+			segment->channels = this->channels;
+			segment->bitsPerSample = this->bitsPerSample;
+			segment->output = &output[segment->start * frameSize];
+			segment->succeeded = false;
+			ownSegments += segment;
+		}
+		DecodeSegmentQueue queue;
+		queue.segments = ownSegments;
+		harray<SegmentDecoderThread*> threads;
+		for_iter (i, 0, threadCount)
+		{
+			threads += new SegmentDecoderThread(&queue);
+			threads.last()->start();
+		}
+		_decodeQueuedSegments(&queue); // this thread takes part as well
+		foreach (SegmentDecoderThread*, it, threads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		lock.acquire(&segmentDecoderMutex);
+		segmentDecoderCount -= threadCount;
+		lock.release();
+		bool result = true;
+		foreach (DecodeSegment*, it, ownSegments)
+		{
+			result &= (*it)->succeeded;
+			delete (*it);
+		}
+		if (!result)
+		{
+			hlog::warn(logTag, "OGG: error decoding segments, decoding sequentially: " + this->filename);
+		}
+		return result;
+	}
+
 	bool OGG_Source::load(hstream& output)
 	{
 		if (!Source::load(output))
 		{
 			return false;
 		}
-		int remaining = this->size;
+		int remaining = (int)this->size;
 		output.prepareManualWriteRaw(remaining);
 		char* buffer = (char*)&output[(int)output.position()];
+		if (this->_loadSegments(buffer))
+		{
+			return true;
+		}
 		int read = 0;
 		while (remaining > 0)
 		{
-			read = (int)ov_read(&this->oggStream, buffer, remaining, 0, 2, 1, &_section);
+			read = _readPcm(this->oggStream, buffer, remaining, this->channels, this->bitsPerSample);
 			if (read == 0)
 			{
 				memset(buffer, 0, remaining);
@@ -156,7 +880,7 @@ namespace xal
 		int read = 0;
 		while (remaining > 0)
 		{
-			read = (int)ov_read(&this->oggStream, buffer, remaining, 0, 2, 1, &_section);
+			read = _readPcm(this->oggStream, buffer, remaining, this->channels, this->bitsPerSample);
 			if (read == 0)
 			{
 				break;
@@ -14,8 +14,13 @@
 #ifndef XAL_OGG_SOURCE_H
 #define XAL_OGG_SOURCE_H
 
+#ifndef _OGG_TREMOR
 #include <vorbis/vorbisfile.h>
+#else
+#include <ivorbisfile.h>
+#endif
 
+#include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
 #include "AudioManager.h"
@@ -33,11 +38,25 @@ namespace xal
 		bool open() override;
 		void close() override;
 		void rewind() override;
+		bool seek(int64_t sample) override;
 		bool load(hstream& output) override;
 		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
 
+		static void clearDecoderCache();
+		static bool createSeekIndex(chstr filename);
+
 	protected:
-		OggVorbis_File oggStream;
+		OggVorbis_File* oggStream;
+		harray<int64_t> seekPointSamples;
+		harray<int64_t> seekPointOffsets;
+		bool seekIndexPending;
+
+		bool _probe() override;
+		void _updateBitsPerSample();
+		bool _loadSegments(char* output);
+		void _loadSeekIndex();
+		void _createSeekIndex();
+		bool _skipSamples(int64_t count);
 
 	};
 
@@ -9,16 +9,36 @@
 #ifdef _FORMAT_WAV
 #include <string.h>
 
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hresource.h>
 
+#include "Adpcm.h"
 #include "AudioManager.h"
+#include "Pcm.h"
+#include "Utility.h"
 #include "WAV_Source.h"
 #include "xal.h"
 
+// formats as defined in the WAVEFORMATEX header
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_IMA_ADPCM 0x11
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+// amount of samples converted in one go, output can be up to 4 bytes per sample
+#define CONVERSION_BLOCK_SAMPLES (STREAM_BUFFER_SIZE / 4)
+
 namespace xal
 {
 	WAV_Source::WAV_Source(chstr filename, SourceMode sourceMode, BufferMode bufferMode) :
-		Source(filename, sourceMode, bufferMode)
+		Source(filename, sourceMode, bufferMode),
+		dataBitsPerSample(0),
+		dataFloat(false),
+		dataRemaining(0),
+		conversionBuffer(NULL),
+		adpcmFramesRemaining(0),
+		decodedFrames(0),
+		decodedPosition(0)
 	{
 	}
 
@@ -40,13 +60,20 @@ namespace xal
 		this->bitsPerSample = 0;
 		this->size = 0;
 		this->duration = 0.0f;
+		this->dataBitsPerSample = 0;
+		this->dataFloat = false;
+		this->adpcmBlockSize = 0;
 		// data loading
 		unsigned char buffer[5] = {0};
 		this->stream->readRaw(buffer, 4); // RIFF
 		this->stream->readRaw(buffer, 4); // file size
 		this->stream->readRaw(buffer, 4); // WAVE
 		hstr tag;
-		int size = 0;
+		unsigned int size = 0; // chunk sizes are unsigned so data chunks can be up to 4 GB
+		int64_t dataSize = 0;
+		int frames = -1;
+		unsigned short format = 0;
+		unsigned short blockAlign = 0;
 		short value16;
 		int value32;
 		while (!this->stream->eof())
@@ -55,52 +82,133 @@ namespace xal
 			tag = (char*)buffer;
 			this->stream->readRaw(buffer, 4); // size of the chunk
 			memcpy(&size, buffer, 4);
-			if (tag == "fmt ")
+			if (tag == "fmt " && size >= 16)
 			{
 				// format
 				this->stream->readRaw(buffer, 2);
+				memcpy(&format, buffer, 2);
+				// channels
+				this->stream->readRaw(buffer, 2);
 				memcpy(&value16, buffer, 2);
-				if (size == 16 && value16 == 1)
+				this->channels = value16;
+				// sampling rate
+				this->stream->readRaw(buffer, 4);
+				memcpy(&value32, buffer, 4);
+				this->samplingRate = value32;
+				// bytes rate
+				this->stream->readRaw(buffer, 4);
+				// blockalign
+				this->stream->readRaw(buffer, 2);
+				memcpy(&blockAlign, buffer, 2);
+				// bits per sample
+				this->stream->readRaw(buffer, 2);
+				memcpy(&value16, buffer, 2);
+				this->dataBitsPerSample = value16;
+				size -= 16;
+				if (format == WAV_FORMAT_EXTENSIBLE && size >= 24)
 				{
-					// channels
-					this->stream->readRaw(buffer, 2);
-					memcpy(&value16, buffer, 2);
-					this->channels = value16;
-					// sampling rate
+					// extension size, valid bits per sample and channel mask
 					this->stream->readRaw(buffer, 4);
-					memcpy(&value32, buffer, 4);
-					this->samplingRate = value32;
-					// bytes rate
 					this->stream->readRaw(buffer, 4);
-					// blockalign
-					this->stream->readRaw(buffer, 2);
-					// bits per sample
+					// the actual format is stored in the first 2 bytes of the sub-format GUID
 					this->stream->readRaw(buffer, 2);
-					memcpy(&value16, buffer, 2);
-					this->bitsPerSample = value16;
-					size = 0;
+					memcpy(&format, buffer, 2);
+					this->stream->seek(14);
+					size -= 24;
 				}
-				else // not PCM, some form of compressed format
+				this->dataFloat = (format == WAV_FORMAT_IEEE_FLOAT);
+				if (format == WAV_FORMAT_IMA_ADPCM && this->dataBitsPerSample == 4 && this->channels > 0 && blockAlign > 4 * this->channels)
 				{
-					size -= 2;
+					this->adpcmBlockSize = blockAlign;
+				}
+				else if (!(format == WAV_FORMAT_PCM && (this->dataBitsPerSample == 8 || this->dataBitsPerSample == 16 || this->dataBitsPerSample == 24 || this->dataBitsPerSample == 32)) &&
+					!(format == WAV_FORMAT_IEEE_FLOAT && this->dataBitsPerSample == FLOAT_BITS_PER_SAMPLE)) // some form of compressed or unsupported format
+				{
+					hlog::errorf(logTag, "Unsupported WAV format %d with %d bits per sample: %s", format, this->dataBitsPerSample, this->filename.cStr());
 					this->close();
 					break;
 				}
 			}
+			else if (tag == "fact" && size >= 4)
+			{
+				// the exact number of frames is only required for compressed data
+				this->stream->readRaw(buffer, 4);
+				memcpy(&frames, buffer, 4);
+				size -= 4;
+			}
 			else if (tag == "data")
 			{
-				this->size += size;
+				dataSize += size;
 			}
+			// chunks are always word-aligned
+			size += (size & 1);
 			if (size > 0)
 			{
 				this->stream->seek(size);
 			}
 		}
-		this->duration = (float)this->size / (this->samplingRate * this->channels * this->bitsPerSample / 8);
+		if (this->streamOpen && this->dataBitsPerSample == 0)
+		{
+			hlog::error(logTag, "No WAV format chunk found: " + this->filename);
+			this->close();
+		}
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		// data that can't be used by the mixer directly is converted to 16 bit or float, whichever the audio manager handles natively
+		this->bitsPerSample = this->dataBitsPerSample;
+		if (this->adpcmBlockSize > 0)
+		{
+			// IMA-ADPCM data is decoded block by block into 16 bit
+			int blockFrames = Adpcm::calcBlockFrames(this->adpcmBlockSize, this->channels);
+			int64_t dataFrames = dataSize / this->adpcmBlockSize * blockFrames;
+			if (dataSize % this->adpcmBlockSize > 0)
+			{
+				dataFrames += Adpcm::calcBlockFrames((int)(dataSize % this->adpcmBlockSize), this->channels);
+			}
+			if (frames >= 0)
+			{
+				dataFrames = hmin((int64_t)frames, dataFrames);
+			}
+			this->bitsPerSample = 16;
+			this->size = dataFrames * this->channels * 2;
+			this->duration = (float)((double)dataFrames / this->samplingRate);
+			if (this->conversionBuffer == NULL)
+			{
+				this->conversionBuffer = new unsigned char[this->adpcmBlockSize + blockFrames * this->channels * 2];
+			}
+			this->_findData();
+			return this->streamOpen;
+		}
+		if (this->dataFloat || this->dataBitsPerSample > 16)
+		{
+			int channels = this->channels;
+			int samplingRate = this->samplingRate;
+			int bitsPerSample = FLOAT_BITS_PER_SAMPLE;
+			this->_getConvertedFormat(channels, samplingRate, bitsPerSample);
+			this->bitsPerSample = (bitsPerSample == FLOAT_BITS_PER_SAMPLE ? FLOAT_BITS_PER_SAMPLE : 16);
+			if ((this->bitsPerSample != this->dataBitsPerSample || !this->dataFloat) && this->conversionBuffer == NULL)
+			{
+				this->conversionBuffer = new unsigned char[CONVERSION_BLOCK_SAMPLES * 8];
+			}
+		}
+		this->size = dataSize / (this->dataBitsPerSample / 8) * (this->bitsPerSample / 8);
+		this->duration = (float)((double)this->size / (this->samplingRate * this->channels * this->bitsPerSample / 8));
 		this->_findData();
 		return this->streamOpen;
 	}
 
+	void WAV_Source::close()
+	{
+		if (this->conversionBuffer != NULL)
+		{
+			delete[] this->conversionBuffer;
+			this->conversionBuffer = NULL;
+		}
+		Source::close();
+	}
+
 	void WAV_Source::rewind()
 	{
 		if (this->streamOpen)
@@ -109,15 +217,58 @@ namespace xal
 		}
 	}
 
+	bool WAV_Source::seek(int64_t sample)
+	{
+		if (!this->streamOpen)
+		{
+			return false;
+		}
+		this->_findData();
+		if (this->adpcmBlockSize > 0)
+		{
+			// whole blocks are skipped, only the block containing the sample has to be decoded
+			int blockFrames = Adpcm::calcBlockFrames(this->adpcmBlockSize, this->channels);
+			int64_t frames = hmin(sample, this->adpcmFramesRemaining);
+			int64_t skipped = hmin(frames / blockFrames * this->adpcmBlockSize, this->dataRemaining);
+			this->stream->seek(skipped);
+			this->dataRemaining -= skipped;
+			this->adpcmFramesRemaining -= frames / blockFrames * blockFrames;
+			frames %= blockFrames;
+			if (frames > 0)
+			{
+				short* decoded = (short*)&this->conversionBuffer[this->adpcmBlockSize];
+				int read = this->stream->readRaw(this->conversionBuffer, (int)hmin((int64_t)this->adpcmBlockSize, this->dataRemaining));
+				if (read <= 0)
+				{
+					return false;
+				}
+				this->dataRemaining -= read;
+				this->decodedFrames = Adpcm::decodeBlock(this->conversionBuffer, read, this->channels, decoded);
+				this->decodedPosition = hmin((int)frames, this->decodedFrames);
+				this->adpcmFramesRemaining -= this->decodedPosition;
+			}
+			return true;
+		}
+		// uncompressed data can be accessed directly
+		int64_t offset = hmin(sample * this->channels * (this->dataBitsPerSample / 8), this->dataRemaining);
+		this->stream->seek(offset);
+		this->dataRemaining -= offset;
+		return true;
+	}
+
 	void WAV_Source::_findData()
 	{
 		this->stream->rewind();
+		this->dataRemaining = 0;
+		this->adpcmFramesRemaining = (this->adpcmBlockSize > 0 ? this->size / (this->channels * 2) : 0);
+		this->decodedFrames = 0;
+		this->decodedPosition = 0;
 		unsigned char buffer[5] = {0};
 		this->stream->readRaw(buffer, 4); // RIFF
 		this->stream->readRaw(buffer, 4); // file size
 		this->stream->readRaw(buffer, 4); // WAVE
 		hstr tag;
-		int size = 0;
+		unsigned int size = 0;
 		while (!this->stream->eof())
 		{
 			this->stream->readRaw(buffer, 4); // next tag
@@ -126,8 +277,10 @@ namespace xal
 			memcpy(&size, buffer, 4);
 			if (tag == "data")
 			{
+				this->dataRemaining = size;
 				break;
 			}
+			size += (size & 1);
 			if (size > 0)
 			{
 				this->stream->seek(size);
@@ -135,13 +288,107 @@ namespace xal
 		}
 	}
 
+	int WAV_Source::_readData(hstream& output, int size)
+	{
+		if (this->adpcmBlockSize > 0)
+		{
+			return this->_readAdpcmData(output, size);
+		}
+		int dataBytes = this->dataBitsPerSample / 8;
+		if (this->conversionBuffer == NULL)
+		{
+			size = (int)hmin((int64_t)size, this->dataRemaining) / dataBytes * dataBytes;
+			int written = output.writeRaw(*this->stream, size);
+			this->dataRemaining -= hmax(written, 0);
+			return hmax(written, 0);
+		}
+		int outputBytes = this->bitsPerSample / 8;
+		unsigned char* input = this->conversionBuffer;
+		unsigned char* converted = &this->conversionBuffer[CONVERSION_BLOCK_SAMPLES * 4];
+		int remaining = size / outputBytes;
+		int written = 0;
+		int count = 0;
+		int read = 0;
+		while (remaining > 0 && this->dataRemaining >= dataBytes)
+		{
+			count = (int)hmin((int64_t)hmin(remaining, CONVERSION_BLOCK_SAMPLES), this->dataRemaining / dataBytes);
+			read = this->stream->readRaw(input, count * dataBytes);
+			if (read <= 0)
+			{
+				break;
+			}
+			this->dataRemaining -= read;
+			count = read / dataBytes;
+			if (this->dataFloat)
+			{
+				Pcm::convertFloatToS16((float*)input, (short*)converted, count);
+			}
+			else if (this->dataBitsPerSample == 24)
+			{
+				if (this->bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+				{
+					Pcm::convertS24ToFloat(input, (float*)converted, count);
+				}
+				else
+				{
+					Pcm::convertS24ToS16(input, (short*)converted, count);
+				}
+			}
+			else if (this->bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+			{
+				Pcm::convertS32ToFloat((int*)input, (float*)converted, count);
+			}
+			else
+			{
+				Pcm::convertS32ToS16((int*)input, (short*)converted, count);
+			}
+			written += output.writeRaw(converted, count * outputBytes);
+			remaining -= count;
+		}
+		return written;
+	}
+
+	int WAV_Source::_readAdpcmData(hstream& output, int size)
+	{
+		int frameSize = this->channels * 2;
+		short* decoded = (short*)&this->conversionBuffer[this->adpcmBlockSize];
+		int remaining = (int)hmin((int64_t)(size / frameSize), this->adpcmFramesRemaining);
+		int written = 0;
+		int count = 0;
+		int read = 0;
+		while (remaining > 0)
+		{
+			if (this->decodedPosition >= this->decodedFrames)
+			{
+				read = this->stream->readRaw(this->conversionBuffer, (int)hmin((int64_t)this->adpcmBlockSize, this->dataRemaining));
+				if (read <= 0)
+				{
+					break;
+				}
+				this->dataRemaining -= read;
+				this->decodedFrames = Adpcm::decodeBlock(this->conversionBuffer, read, this->channels, decoded);
+				this->decodedPosition = 0;
+				if (this->decodedFrames == 0)
+				{
+					break;
+				}
+			}
+			count = hmin(remaining, this->decodedFrames - this->decodedPosition);
+			written += output.writeRaw((unsigned char*)&decoded[this->decodedPosition * this->channels], count * frameSize);
+			this->decodedPosition += count;
+			this->adpcmFramesRemaining -= count;
+			remaining -= count;
+		}
+		return written;
+	}
+
 	bool WAV_Source::load(hstream& output)
 	{
-		if (Source::load(output) == 0)
+		if (!Source::load(output))
 		{
 			return false;
 		}
-		int written = output.writeRaw(*this->stream, this->size);
+		int written = this->_readData(output, (int)this->size);
 		if (written > 0)
 		{
 			output.seek(-written);
@@ -156,7 +403,7 @@ namespace xal
 		{
 			return 0;
 		}
-		int written = output.writeRaw(this->stream, size);
+		int written = this->_readData(output, size);
 		if (written > 0)
 		{
 			output.seek(-written);
@@ -164,5 +411,22 @@ namespace xal
 		return written;
 	}
 
+	bool WAV_Source::loadAdpcm(hstream& output)
+	{
+		if (this->adpcmBlockSize == 0 || !Source::load(output))
+		{
+			return false;
+		}
+		int written = output.writeRaw(*this->stream, (int)this->dataRemaining);
+		if (written > 0)
+		{
+			this->dataRemaining -= written;
+			this->adpcmFramesRemaining = 0;
+			output.seek(-written);
+			return true;
+		}
+		return false;
+	}
+
 }
 #endif
@@ -30,12 +30,25 @@ namespace xal
 		~WAV_Source();
 
 		bool open() override;
+		void close() override;
 		void rewind() override;
+		bool seek(int64_t sample) override;
 		bool load(hstream& output) override;
 		int loadChunk(hstream& output, int size = STREAM_BUFFER_SIZE) override;
+		bool loadAdpcm(hstream& output) override;
 
 	protected:
+		int dataBitsPerSample;
+		bool dataFloat;
+		int64_t dataRemaining;
+		unsigned char* conversionBuffer;
+		int64_t adpcmFramesRemaining;
+		int decodedFrames;
+		int decodedPosition;
+
 		void _findData();
+		int _readData(hstream& output, int size);
+		int _readAdpcmData(hstream& output, int size);
 
 	};
 
@@ -53,14 +53,14 @@ namespace xal
 		return ((status & DSBSTATUS_PLAYING) != 0);
 	}
 
-	unsigned int DirectSound_Player::_systemGetBufferPosition() const
+	int64_t DirectSound_Player::_systemGetBufferPosition() const
 	{
 		unsigned long position = 0;
 		if (this->dsBuffer != NULL)
 		{
 			this->dsBuffer->GetCurrentPosition(&position, NULL);
 		}
-		return (unsigned int)position;
+		return (int64_t)position;
 	}
 
 	float DirectSound_Player::_systemGetOffset() const
@@ -94,7 +94,7 @@ namespace xal
 		memset(&bufferDesc, 0, sizeof(DSBUFFERDESC));
 		bufferDesc.dwSize = sizeof(DSBUFFERDESC);
 		bufferDesc.dwFlags = (DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY | DSBCAPS_CTRLPOSITIONNOTIFY | DSBCAPS_GLOBALFOCUS);
-		bufferDesc.dwBufferBytes = (!this->sound->isStreamed() ? this->buffer->getSize() : STREAM_BUFFER);
+		bufferDesc.dwBufferBytes = (!this->sound->isStreamed() ? (DWORD)this->buffer->getSize() : STREAM_BUFFER);
 		bufferDesc.lpwfxFormat = &wavefmt;
 		HRESULT result = ((DirectSound_AudioManager*)xal::manager)->dsDevice->CreateSoundBuffer(&bufferDesc, &this->dsBuffer, NULL);
 		if (FAILED(result))
@@ -111,6 +111,10 @@ namespace xal
 		{
 			hstream& stream = this->buffer->getStream();
 			this->_copyBuffer(stream, (int)stream.size());
+			if (this->seekSample >= 0)
+			{
+				this->_systemSetOffset((float)(this->seekSample * this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8));
+			}
 			return;
 		}
 		int count = STREAM_BUFFER_COUNT;
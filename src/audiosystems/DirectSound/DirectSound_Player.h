@@ -36,7 +36,7 @@ namespace xal
 		int bufferQueued;
 
 		bool _systemIsPlaying() const;
-		unsigned int _systemGetBufferPosition() const;
+		int64_t _systemGetBufferPosition() const;
 		float _systemGetOffset() const;
 		void _systemSetOffset(float value);
 		bool _systemPreparePlay();
@@ -36,6 +36,7 @@ namespace xal
 		this->createOpenALBuffers();
 #ifdef _MAC
 		this->macSampleOffset = -1;
+		this->macSeekSample = -1;
 #endif
 	}
 	
@@ -80,7 +81,7 @@ namespace xal
 		return (state == AL_PLAYING);
 	}
 	
-	unsigned int OpenAL_Player::_systemGetBufferPosition() const
+	int64_t OpenAL_Player::_systemGetBufferPosition() const
 	{
 		int bytes = 0;
 		if (this->sourceId != 0)
@@ -132,6 +133,32 @@ namespace xal
 		}
 	}
 	
+	void OpenAL_Player::_setSampleOffset(int sample)
+	{
+		// a float can't represent every sample position above 2^24 so seeking uses the integer version
+#ifndef __APPLE__
+		if (this->sourceId != 0)
+#else
+		if (this->sourceId != 0 && !this->sound->isStreamed()) // see _systemSetOffset()
+#endif
+		{
+#ifdef _MAC
+			int state;
+			alGetSourcei(this->sourceId, AL_SOURCE_STATE, &state);
+			if (state == AL_PLAYING)
+			{
+				alSourcei(this->sourceId, AL_SAMPLE_OFFSET, (ALint)sample);
+			}
+			else
+			{
+				this->macSeekSample = sample;
+			}
+#else
+			alSourcei(this->sourceId, AL_SAMPLE_OFFSET, (ALint)sample);
+#endif
+		}
+	}
+	
 	bool OpenAL_Player::_systemPreparePlay()
 	{
 		if (this->sourceId == 0)
@@ -149,6 +176,10 @@ namespace xal
 			this->_fillBuffers(0, 1);
 			alSourcei(this->sourceId, AL_BUFFER, this->bufferIds[0]);
 			alSourcei(this->sourceId, AL_LOOPING, this->looping);
+			if (this->seekSample >= 0)
+			{
+				this->_setSampleOffset((int)this->seekSample);
+			}
 		}
 		else
 		{
@@ -198,6 +229,11 @@ namespace xal
 				alSourcef(this->sourceId, AL_SAMPLE_OFFSET, this->macSampleOffset);
 				this->macSampleOffset = -1;
 			}
+			if (this->macSeekSample >= 0)
+			{
+				alSourcei(this->sourceId, AL_SAMPLE_OFFSET, (ALint)this->macSeekSample);
+				this->macSeekSample = -1;
+			}
 #endif
 			if (this->pendingPitchUpdate)
 			{
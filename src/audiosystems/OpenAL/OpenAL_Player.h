@@ -45,7 +45,7 @@ namespace xal
 		void _update(float timeDelta);
 
 		bool _systemIsPlaying() const;
-		unsigned int _systemGetBufferPosition() const;
+		int64_t _systemGetBufferPosition() const;
 		float _systemGetOffset() const;
 		void _systemSetOffset(float value);
 		bool _systemPreparePlay();
@@ -63,8 +63,10 @@ namespace xal
 		void _queueBuffers();
 		void _unqueueBuffers(int index, int count);
 		void _unqueueBuffers();
+		void _setSampleOffset(int sample);
 #ifdef _MAC
 		float macSampleOffset;
+		int macSeekSample;
 #endif
 		bool pendingPitchUpdate;
 
@@ -121,15 +121,15 @@ namespace xal
 		return this->playing;
 	}
 
-	unsigned int OpenSLES_Player::_systemGetBufferPosition() const
+	int64_t OpenSLES_Player::_systemGetBufferPosition() const
 	{
-		int bytes = 0;
+		int64_t bytes = 0;
 		SLmillisecond milliseconds = 0;
 		SLresult result = __CPP_WRAP_ARGS(this->player, GetPosition, (SLmillisecond*)&milliseconds);
 		if (result == SL_RESULT_SUCCESS)
 		{
-			// first comes "* 0.001", because it can cause an int overflow otherwise
-			bytes = (int)(milliseconds * 0.001f * this->buffer->getSamplingRate() * (this->buffer->getBitsPerSample() / 8) * this->buffer->getChannels());
+			// calculated in 64 bit, because long streams would cause an int overflow otherwise
+			bytes = (int64_t)milliseconds * this->buffer->getSamplingRate() / 1000 * (this->buffer->getBitsPerSample() / 8) * this->buffer->getChannels();
 			if (!this->sound->isStreamed() && this->looping)
 			{
 				bytes %= this->buffer->getSize();
@@ -228,7 +228,7 @@ namespace xal
 			{
 				if (!this->paused)
 				{
-					this->_enqueueBuffer(this->buffer->getStream());
+					this->_enqueueBuffer(this->buffer->getStream(), this->_getSeekOffset());
 				}
 				return;
 			}
@@ -243,7 +243,8 @@ namespace xal
 			}
 			for_iter (i, 0, count)
 			{
-				this->_enqueueBuffer(this->buffer->getStream());
+				// only the first queued loop starts at the seeked position
+				this->_enqueueBuffer(this->buffer->getStream(), (i == 0 ? this->_getSeekOffset() : 0));
 			}
 			return;
 		}
@@ -430,9 +431,18 @@ namespace xal
 		return 0; // because _systemGetBufferPosition() works on this platform properly and doesn't need this
 	}
 
-	void OpenSLES_Player::_enqueueBuffer(hstream& stream)
+	int OpenSLES_Player::_getSeekOffset()
+	{
+		if (this->seekSample < 0)
+		{
+			return 0;
+		}
+		return (int)hmin(this->seekSample * this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8, this->buffer->getStream().size());
+	}
+
+	void OpenSLES_Player::_enqueueBuffer(hstream& stream, int offset)
 	{
-		SLresult result = __CPP_WRAP_ARGS(this->playerBufferQueue, Enqueue, (unsigned char*)stream, (int)stream.size());
+		SLresult result = __CPP_WRAP_ARGS(this->playerBufferQueue, Enqueue, &stream[offset], (int)stream.size() - offset);
 		if (result == SL_RESULT_SUCCESS)
 		{
 			++this->buffersEnqueued;
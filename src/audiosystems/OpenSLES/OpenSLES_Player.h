@@ -52,7 +52,7 @@ namespace xal
 		void _update(float timeDelta) override;
 
 		bool _systemIsPlaying() const override;
-		unsigned int _systemGetBufferPosition() const override;
+		int64_t _systemGetBufferPosition() const override;
 		bool _systemNeedsStreamedBufferPositionCorrection() const  override{ return false; }
 		bool _systemPreparePlay() override;
 		void _systemPrepareBuffer() override;
@@ -63,7 +63,8 @@ namespace xal
 		void _systemUpdateNormal() override;
 		int _systemUpdateStream() override;
 
-		void _enqueueBuffer(hstream& stream);
+		int _getSeekOffset();
+		void _enqueueBuffer(hstream& stream, int offset = 0);
 		int _fillStreamBuffers(int count);
 		void _enqueueStreamBuffers(int count);
 
@@ -18,6 +18,7 @@
 #include "SDL_Player.h"
 #include "Source.h"
 #include "Buffer.h"
+#include "Utility.h"
 #include "xal.h"
 
 namespace xal
@@ -91,22 +92,35 @@ namespace xal
 		((SDL_AudioManager*)xal::manager)->mixAudio(unused, stream, length);
 	}
 	
-	void SDL_AudioManager::_convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSample, Source* source, hstream& stream)
+	void SDL_AudioManager::_convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSample, hstream& stream)
 	{
 		if (stream.size() == 0)
 		{
 			return;
 		}
-		SDL_AudioSpec format = this->getFormat();
-		int sdlFormat = (bitsPerSample == 16 ? AUDIO_S16 : AUDIO_S8);
-		if (sdlFormat == format.format && channels == format.channels && samplingRate == format.freq)
+		int outputChannels = channels;
+		int outputSamplingRate = samplingRate;
+		int outputBitsPerSample = bitsPerSample;
+		this->_getConvertedFormat(outputChannels, outputSamplingRate, outputBitsPerSample);
+		if (outputChannels == channels && outputSamplingRate == samplingRate && outputBitsPerSample == bitsPerSample)
 		{
 			return;
 		}
+		// SDL's converter doesn't handle float data so it has to be converted to 16 bit beforehand
+		if (bitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			AudioManager::_convertStream(logicalName, channels, samplingRate, bitsPerSample, stream);
+			bitsPerSample = 16;
+		}
 		SDL_AudioCVT cvt;
 		cvt.buf = NULL;
-		int result = SDL_BuildAudioCVT(&cvt, sdlFormat, channels, samplingRate, format.format, format.channels, format.freq);
-		if (result <= 0)
+		int result = SDL_BuildAudioCVT(&cvt, SDL_AudioManager::_getSdlFormat(bitsPerSample), channels, samplingRate,
+			SDL_AudioManager::_getSdlFormat(outputBitsPerSample), outputChannels, outputSamplingRate);
+		if (result == 0) // no conversion needed
+		{
+			return;
+		}
+		if (result < 0)
 		{
 			hlog::error(logTag, "Could not build converter: " + logicalName);
 			return;
@@ -135,12 +149,33 @@ namespace xal
 			int written = stream.writeRaw(cvt.buf, cvt.len_cvt);
 			if (written > 0)
 			{
+				stream.truncate(stream.position());
 				stream.seek(-written);
 			}
 		}
 		delete[] cvt.buf;
 		cvt.buf = NULL;
-		return;
+	}
+
+	void SDL_AudioManager::_getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const
+	{
+		// the mixer handles mono and stereo data in 8 bit, 16 bit and float natively, only the sampling rate has to match the device
+		if (channels < 1 || channels > 2 || (bitsPerSample != 8 && bitsPerSample != 16 && bitsPerSample != FLOAT_BITS_PER_SAMPLE))
+		{
+			channels = this->format.channels;
+			bitsPerSample = (this->format.format == AUDIO_S16 ? 16 : 8);
+		}
+		else if (bitsPerSample == FLOAT_BITS_PER_SAMPLE && samplingRate != this->format.freq)
+		{
+			bitsPerSample = 16; // SDL can't resample float data
+		}
+		samplingRate = this->format.freq;
+	}
+
+	int SDL_AudioManager::_getSdlFormat(int bitsPerSample)
+	{
+		// 8 bit PCM data is always unsigned
+		return (bitsPerSample == 16 ? AUDIO_S16 : AUDIO_U8);
 	}
 
 }
@@ -51,7 +51,10 @@ namespace xal
 
 		static void _mixAudio(void* unused, unsigned char* stream, int length);
 
-		void _convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSampl, hstream& stream);
+		void _convertStream(chstr logicalName, int channels, int samplingRate, int bitsPerSample, hstream& stream);
+		void _getConvertedFormat(int& channels, int& samplingRate, int& bitsPerSample) const;
+
+		static int _getSdlFormat(int bitsPerSample);
 		
 	};
 
@@ -15,17 +15,103 @@
 #include "SDL_AudioManager.h"
 #include "SDL_Player.h"
 #include "Sound.h"
+#include "Utility.h"
 #include "xal.h"
 
 namespace xal
 {
+	typedef void (*MixFunction)(short*, const unsigned char*, int, float);
+
+	static inline int _toShort(unsigned char value)
+	{
+		return (((int)value - 128) << 8); // 8 bit PCM data is unsigned
+	}
+
+	static inline int _toShort(short value)
+	{
+		return value;
+	}
+
+	static inline int _toShort(float value)
+	{
+		return (int)(hclamp(value, -1.0f, 1.0f) * 32767.0f); // clipping instead of wrapping around, resampling can overshoot
+	}
+
+	// mixes interleaved input frames into 16 bit output while converting the sample format and channel layout on the fly
+	template <typename T, int INPUT_CHANNELS, int OUTPUT_CHANNELS, bool FIRST>
+	static void _mixFrames(short* output, const unsigned char* input, int frames, float gain)
+	{
+		const T* samples = (const T*)input;
+		int left = 0;
+		int right = 0;
+		for_iter (i, 0, frames)
+		{
+			left = (int)(_toShort(samples[i * INPUT_CHANNELS]) * gain);
+			right = (INPUT_CHANNELS == 2 ? (int)(_toShort(samples[i * INPUT_CHANNELS + 1]) * gain) : left);
+			if (OUTPUT_CHANNELS == 1)
+			{
+				left = (left + right) / 2;
+				if (!FIRST)
+				{
+					left += output[i];
+				}
+				output[i] = (short)hclamp(left, -32768, 32767);
+			}
+			else
+			{
+				if (!FIRST)
+				{
+					left += output[i * 2];
+					right += output[i * 2 + 1];
+				}
+				output[i * 2] = (short)hclamp(left, -32768, 32767);
+				output[i * 2 + 1] = (short)hclamp(right, -32768, 32767);
+			}
+		}
+	}
+
+	template <typename T, int INPUT_CHANNELS>
+	static MixFunction _getMixFunction(int outputChannels, bool first)
+	{
+		if (outputChannels == 1)
+		{
+			return (first ? &_mixFrames<T, INPUT_CHANNELS, 1, true> : &_mixFrames<T, INPUT_CHANNELS, 1, false>);
+		}
+		return (first ? &_mixFrames<T, INPUT_CHANNELS, 2, true> : &_mixFrames<T, INPUT_CHANNELS, 2, false>);
+	}
+
+	template <typename T>
+	static MixFunction _getMixFunction(int inputChannels, int outputChannels, bool first)
+	{
+		if (inputChannels == 1)
+		{
+			return _getMixFunction<T, 1>(outputChannels, first);
+		}
+		return _getMixFunction<T, 2>(outputChannels, first);
+	}
+
+	static MixFunction _getMixFunction(int inputChannels, int inputBitsPerSample, int outputChannels, bool first)
+	{
+		if (inputBitsPerSample == 8)
+		{
+			return _getMixFunction<unsigned char>(inputChannels, outputChannels, first);
+		}
+		if (inputBitsPerSample == FLOAT_BITS_PER_SAMPLE)
+		{
+			return _getMixFunction<float>(inputChannels, outputChannels, first);
+		}
+		return _getMixFunction<short>(inputChannels, outputChannels, first);
+	}
+
 	SDL_Player::SDL_Player(Sound* sound) :
 		Player(sound),
 		playing(false),
 		position(0),
 		currentGain(1.0f),
 		readPosition(0),
-		writePosition(0)
+		writePosition(0),
+		inputChannels(2),
+		inputBitsPerSample(16)
 	{
 		memset(this->circleBuffer, 0, STREAM_BUFFER * sizeof(unsigned char));
 	}
@@ -77,7 +163,7 @@ namespace xal
 	{
 		Player::_update(timeDelta);
 		// making sure a corrected size is used
-		int size = this->buffer->calcOutputSize(this->buffer->getSize());
+		int64_t size = this->buffer->calcOutputSize(this->buffer->getSize());
 		if (size > 0 && this->position >= size)
 		{
 			if (this->looping)
@@ -97,14 +183,18 @@ namespace xal
 		{
 			return false;
 		}
+		int outputChannels = xal::manager->getChannels();
+		int outputFrameSize = outputChannels * sizeof(short);
+		int inputFrameSize = this->inputChannels * this->inputBitsPerSample / 8;
+		int frames = size / outputFrameSize;
 		unsigned char* data1 = NULL;
 		int size1 = 0;
 		unsigned char* data2 = NULL;
 		int size2 = 0;
-		this->_getData(size, &data1, &size1, &data2, &size2); // ironically this is very similar to how DirectSound does things internally
+		this->_getData(frames * inputFrameSize, &data1, &size1, &data2, &size2); // ironically this is very similar to how DirectSound does things internally
 		if (size1 > 0)
 		{
-			if (first && this->currentGain == 1.0f)
+			if (first && this->currentGain == 1.0f && this->inputBitsPerSample == 16 && this->inputChannels == outputChannels)
 			{
 				memcpy((unsigned char*)stream, data1, size1);
 				if (size2 > 0)
@@ -114,32 +204,13 @@ namespace xal
 			}
 			else
 			{
+				MixFunction mix = _getMixFunction(this->inputChannels, this->inputBitsPerSample, outputChannels, first);
 				short* sStream = (short*)(unsigned char*)stream;
-				short* sData1 = (short*)data1;
-				short* sData2 = (short*)data2;
-				size1 = size1 * sizeof(unsigned char) / sizeof(short);
-				size2 = size2 * sizeof(unsigned char) / sizeof(short);
-				if (!first)
-				{
-					for_iter (i, 0, size1)
-					{
-						sStream[i] = (short)hclamp((int)(sStream[i] + this->currentGain * sData1[i]), -32768, 32767);
-					}
-					for_iter (i, 0, size2)
-					{
-						sStream[size1 + i] = (short)hclamp((int)(sStream[size1 + i] + this->currentGain * sData2[i]), -32768, 32767);
-					}
-				}
-				else
+				int frames1 = size1 / inputFrameSize;
+				(*mix)(sStream, data1, frames1, this->currentGain);
+				if (size2 > 0)
 				{
-					for_iter (i, 0, size1)
-					{
-						sStream[i] = (short)(sData1[i] * this->currentGain);
-					}
-					for_iter (i, 0, size2)
-					{
-						sStream[size1 + i] = (short)(sData2[i] * this->currentGain);
-					}
+					(*mix)(&sStream[frames1 * outputChannels], data2, size2 / inputFrameSize, this->currentGain);
 				}
 			}
 			this->position += size1 + size2;
@@ -147,7 +218,7 @@ namespace xal
 		return true;
 	}
 
-	unsigned int SDL_Player::_systemGetBufferPosition() const
+	int64_t SDL_Player::_systemGetBufferPosition() const
 	{
 		int count = 0;
 		if (this->readPosition > this->writePosition)
@@ -178,9 +249,18 @@ namespace xal
 
 	void SDL_Player::_systemPrepareBuffer()
 	{
+		this->_updateInputFormat();
 		if (!this->sound->isStreamed())
 		{
-			this->buffer->load(this->looping, this->buffer->getSize());
+			this->buffer->load(this->looping, (int)this->buffer->getSize());
+			if (this->seekSample >= 0)
+			{
+				// the loaded data is already converted so the offset has to be converted as well
+				int inputFrameSize = this->inputChannels * this->inputBitsPerSample / 8;
+				int offset = (int)this->buffer->calcOutputSize(this->seekSample * this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8);
+				this->readPosition = offset / inputFrameSize * inputFrameSize;
+				this->position = this->readPosition;
+			}
 			return;
 		}
 		if (!this->paused)
@@ -190,7 +270,7 @@ namespace xal
 			int size = this->_fillBuffer(STREAM_BUFFER);
 			if (size < STREAM_BUFFER)
 			{
-				memset(&this->circleBuffer[size], 0, (STREAM_BUFFER - size) * sizeof(unsigned char));
+				memset(&this->circleBuffer[size], this->_getSilenceValue(), (STREAM_BUFFER - size) * sizeof(unsigned char));
 			}
 		}
 	}
@@ -233,15 +313,29 @@ namespace xal
 		if (count > 0)
 		{
 			result = this->_fillBuffer(count * STREAM_BUFFER_SIZE);
-			result = this->buffer->calcInputSize(result);
+			result = (int)this->buffer->calcInputSize(result);
 		}
 		return result;
 	}
 
+	int SDL_Player::_getSilenceValue() const
+	{
+		return (this->inputBitsPerSample == 8 ? 0x80 : 0); // 8-bit data is unsigned
+	}
+
+	void SDL_Player::_updateInputFormat()
+	{
+		// the mixer reads the buffer data in whatever format the audio manager left it after conversion
+		this->inputChannels = this->buffer->getChannels();
+		int samplingRate = this->buffer->getSamplingRate();
+		this->inputBitsPerSample = this->buffer->getBitsPerSample();
+		((SDL_AudioManager*)xal::manager)->_getConvertedFormat(this->inputChannels, samplingRate, this->inputBitsPerSample);
+	}
+
 	int SDL_Player::_fillBuffer(int size)
 	{
 		// making sure the buffer doesn't overflow since upsampling can cause that
-		size = this->buffer->calcInputSize(size);
+		size = (int)this->buffer->calcInputSize(size);
 		// load the data from the buffer
 		int streamSize = this->buffer->load(this->looping, size);
 		hstream& stream = this->buffer->getStream();
@@ -258,16 +352,17 @@ namespace xal
 		this->writePosition = (this->writePosition + streamSize) % STREAM_BUFFER;
 		if (!this->looping && streamSize < size) // fill with silence if source is at the end
 		{
+			int silence = this->_getSilenceValue();
 			streamSize = size - streamSize;
 			if (this->writePosition + streamSize <= STREAM_BUFFER)
 			{
-				memset(&this->circleBuffer[this->writePosition], 0, streamSize * sizeof(unsigned char));
+				memset(&this->circleBuffer[this->writePosition], silence, streamSize * sizeof(unsigned char));
 			}
 			else
 			{
 				int remaining = STREAM_BUFFER - this->writePosition;
-				memset(&this->circleBuffer[this->writePosition], 0, remaining * sizeof(unsigned char));
-				memset(this->circleBuffer, 0, (streamSize - remaining) * sizeof(unsigned char));
+				memset(&this->circleBuffer[this->writePosition], silence, remaining * sizeof(unsigned char));
+				memset(this->circleBuffer, silence, (streamSize - remaining) * sizeof(unsigned char));
 			}
 			this->writePosition = (this->writePosition + streamSize) % STREAM_BUFFER;
 			streamSize = size;
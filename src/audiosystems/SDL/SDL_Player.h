@@ -32,16 +32,18 @@ namespace xal
 
 	protected:
 		bool playing;
-		int position;
+		int64_t position;
 		float currentGain;
 		unsigned char circleBuffer[STREAM_BUFFER];
 		int readPosition;
 		int writePosition;
+		int inputChannels;
+		int inputBitsPerSample;
 
 		void _update(float timeDelta);
 
 		inline bool _systemIsPlaying() const { return this->playing; }
-		unsigned int _systemGetBufferPosition() const;
+		int64_t _systemGetBufferPosition() const;
 		float _systemGetOffset() const;
 		void _systemSetOffset(float value);
 		bool _systemPreparePlay();
@@ -51,6 +53,8 @@ namespace xal
 		int _systemStop();
 		int _systemUpdateStream();
 
+		int _getSilenceValue() const;
+		void _updateInputFormat();
 		int _fillBuffer(int size);
 		void _getData(int size, unsigned char** data1, int* size1, unsigned char** data2, int* size2);
 
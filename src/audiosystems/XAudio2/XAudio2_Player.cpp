@@ -111,10 +111,10 @@ namespace xal
 		return this->playing;
 	}
 
-	unsigned int XAudio2_Player::_systemGetBufferPosition() const
+	int64_t XAudio2_Player::_systemGetBufferPosition() const
 	{
 		this->sourceVoice->GetState((XAUDIO2_VOICE_STATE*)&this->xa2State[0], 0);
-		return (unsigned int)(this->xa2State[0].SamplesPlayed * this->buffer->getChannels() * this->buffer->getBitsPerSample() * 0.125f);
+		return (int64_t)(this->xa2State[0].SamplesPlayed * this->buffer->getChannels() * this->buffer->getBitsPerSample() / 8);
 	}
 
 	bool XAudio2_Player::_systemPreparePlay()
@@ -147,7 +147,12 @@ namespace xal
 		{
 			if (!this->paused)
 			{
+				if (this->seekSample >= 0)
+				{
+					this->xa2Buffer.PlayBegin = (UINT32)this->seekSample;
+				}
 				this->_submitBuffer(this->buffer->getStream());
+				this->xa2Buffer.PlayBegin = 0;
 			}
 			return;
 		}
@@ -67,7 +67,7 @@ namespace xal
 		void _update(float timeDelta);
 
 		bool _systemIsPlaying() const;
-		unsigned int _systemGetBufferPosition() const;
+		int64_t _systemGetBufferPosition() const;
 		bool _systemPreparePlay();
 		void _systemPrepareBuffer();
 		void _systemUpdateGain();
@@ -0,0 +1,35 @@
+/// @file
+/// @version 4.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Packs all audio files of a directory into a sound bank that can be loaded with AudioManager::createSoundsFromBank().
+/// Usage: xalbank <input path> <output bank filename>
+
+#include <stdio.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include <xal/AudioManager.h>
+#include <xal/xal.h>
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: xalbank <input path> <output bank filename>\n");
+		printf("Every directory in the input path becomes a category, the audio files inside become its sounds.\n");
+		return 1;
+	}
+	// no audio output is needed, only the decoders are used to probe the files
+	xal::init(xal::AudioSystemType::Disabled, NULL, false);
+	bool result = xal::manager->createBank(argv[1], argv[2]);
+	xal::destroy();
+	return (result ? 0 : 1);
+}